@@ -0,0 +1,109 @@
+/*
+ * miniconf_allocations.h
+ *
+ * Counting heap allocations in the examples. The header replaces the global
+ * operator new and operator delete, so it is included by the file containing
+ * main() and by no other file of the program.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+
+#ifndef __MINICONF_ALLOCATIONS_H__
+#define __MINICONF_ALLOCATIONS_H__
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if defined(__cpp_aligned_new) && defined(_WIN32)
+#include <malloc.h>
+#endif
+
+// every allocation of the program goes through the replaced operator new
+static std::atomic<unsigned long> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = malloc(size != 0 ? size : 1);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+#ifdef __cpp_aligned_new
+// over-aligned types are allocated through these since C++17
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+#if defined(_WIN32)
+    void* memory = _aligned_malloc(size != 0 ? size : 1, static_cast<size_t>(alignment));
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, static_cast<size_t>(alignment), size != 0 ? size : 1) != 0) {
+        memory = nullptr;
+    }
+#endif
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#if defined(_WIN32)
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void operator delete[](void* memory, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(memory, alignment);
+}
+#endif
+
+#endif
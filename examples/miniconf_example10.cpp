@@ -0,0 +1,130 @@
+/*
+ * miniconf example 10
+ *
+ * Timing the numeric parsing of command line values against sscanf, which
+ * parseValue() used before, and checking that the parsed values are the
+ * ones strtod and strtol give.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/* Writes a random number in one of the notations found in config files */
+static std::string randomNumber(std::mt19937& random)
+{
+    char token[64];
+    std::uniform_real_distribution<double> mantissa(-1000.0, 1000.0);
+    switch (random() % 4) {
+        case 0: snprintf(token, sizeof(token), "%.17g", mantissa(random) * std::pow(10.0, static_cast<int>(random() % 61) - 30)); break;
+        case 1: snprintf(token, sizeof(token), "%.3f", mantissa(random)); break;
+        case 2: snprintf(token, sizeof(token), "%de%d", static_cast<int>(random() % 100000), static_cast<int>(random() % 41) - 20); break;
+        default: snprintf(token, sizeof(token), "%.6g", mantissa(random)); break;
+    }
+    return token;
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int optionCount = 1000;
+    int rounds = (argc > 1) ? atoi(argv[1]) : 100;
+
+    // every round assigns a new value to each of the number and integer options
+    // the same values are parsed into string options, which takes everything but the numeric parsing
+    miniconf::Config conf;
+    miniconf::Config strings;
+    conf.log(miniconf::Config::LogLevel::NONE);
+    strings.log(miniconf::Config::LogLevel::NONE);
+    std::vector<std::string> flags;
+    for (int i = 0; i < optionCount; ++i) {
+        conf.option("number" + std::to_string(i)).defaultValue(0.0).required(false);
+        conf.option("integer" + std::to_string(i)).defaultValue(0).required(false);
+        strings.option("number" + std::to_string(i)).defaultValue("").required(false);
+        strings.option("integer" + std::to_string(i)).defaultValue("").required(false);
+        flags.push_back("--number" + std::to_string(i));
+        flags.push_back("--integer" + std::to_string(i));
+    }
+
+    std::mt19937 random(7);
+    double parseTime = 0.0;
+    double stringTime = 0.0;
+    double sscanfTime = 0.0;
+    double strtodTime = 0.0;
+    size_t mismatches = 0;
+    double checksum = 0.0;
+    for (int round = 0; round < rounds; ++round) {
+        std::vector<std::string> tokens;
+        for (int i = 0; i < optionCount; ++i) {
+            tokens.push_back(randomNumber(random));
+            tokens.push_back(std::to_string(static_cast<int>(random())));
+        }
+        std::vector<char*> arguments(1, argv[0]);
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            arguments.push_back(const_cast<char*>(flags[i].c_str()));
+            arguments.push_back(const_cast<char*>(tokens[i].c_str()));
+        }
+
+        auto begin = std::chrono::steady_clock::now();
+        conf.parse(static_cast<int>(arguments.size()), arguments.data());
+        parseTime += secondsSince(begin);
+
+        begin = std::chrono::steady_clock::now();
+        strings.parse(static_cast<int>(arguments.size()), arguments.data());
+        stringTime += secondsSince(begin);
+
+        begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < tokens.size(); i += 2) {
+            double number = 0.0;
+            int integer = 0;
+            sscanf(tokens[i].c_str(), "%lf", &number);
+            sscanf(tokens[i + 1].c_str(), "%d", &integer);
+            checksum += number + integer;
+        }
+        sscanfTime += secondsSince(begin);
+
+        begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < tokens.size(); i += 2) {
+            checksum += strtod(tokens[i].c_str(), nullptr) + strtol(tokens[i + 1].c_str(), nullptr, 10);
+        }
+        strtodTime += secondsSince(begin);
+
+        // the values must be bit-identical to strtod and strtol
+        for (int i = 0; i < optionCount; ++i) {
+            double expected = strtod(tokens[2 * i].c_str(), nullptr);
+            double parsed = conf[flags[2 * i].substr(2)].getNumber();
+            if (memcmp(&expected, &parsed, sizeof(double)) != 0 ||
+                    conf[flags[2 * i + 1].substr(2)].getInt() != strtol(tokens[2 * i + 1].c_str(), nullptr, 10)) {
+                ++mismatches;
+            }
+        }
+    }
+
+    // sscanf accepted trailing garbage, which is rejected now
+    char* garbage[] = { argv[0], const_cast<char*>("--integer0"), const_cast<char*>("12abc") };
+    conf.parse(3, garbage);
+    bool rejected = (conf["integer0"].getInt() == 0);
+
+    double values = 2.0 * optionCount * rounds;
+    printf("%.0f values\n", values);
+    printf("  parse():          %7.1f ns per value\n", parseTime / values * 1e9);
+    printf("  parse() strings:  %7.1f ns per value\n", stringTime / values * 1e9);
+    printf("  numeric parsing:  %7.1f ns per value (the difference)\n", (parseTime - stringTime) / values * 1e9);
+    printf("  sscanf:           %7.1f ns per value\n", sscanfTime / values * 1e9);
+    printf("  strtod / strtol:  %7.1f ns per value\n", strtodTime / values * 1e9);
+    printf("  %zu value(s) differ from strtod / strtol, \"12abc\" is %s\n", mismatches, rejected ? "rejected" : "accepted");
+    printf("checksum %g\n", checksum);
+    return (mismatches == 0 && rejected) ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+ * miniconf example 11
+ *
+ * Measuring the throughput of loading a large CSV file in MB/s. For
+ * comparison, the file is also split with a stringstream per line and
+ * std::getline per field, like loadCSV() did before, without storing the
+ * values.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <miniconf.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/* Writes "rowCount" rows of numbers, integers, strings and quoted strings, returns the file size */
+static long writeTable(const std::string& path, int rowCount)
+{
+    FILE* fd = fopen(path.c_str(), "w");
+    if (fd == nullptr) {
+        return 0;
+    }
+    for (int row = 0; row < rowCount; ++row) {
+        switch (row % 4) {
+            case 0: fprintf(fd, "table%d.gain%d,%d.%03d\n", row % 100, row, row % 977, row % 1000); break;
+            case 1: fprintf(fd, "table%d.count%d,%d\n", row % 100, row, row * 7); break;
+            case 2: fprintf(fd, "table%d.name%d,channel %d\n", row % 100, row, row); break;
+            default: fprintf(fd, "table%d.label%d,\"left, right \"\"%d\"\"\"\n", row % 100, row, row); break;
+        }
+    }
+    long size = ftell(fd);
+    fclose(fd);
+    return size;
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int rowCount = (argc > 1) ? atoi(argv[1]) : 500000;
+    int runs = (argc > 2) ? atoi(argv[2]) : 3;
+    std::string path = "demo_table.csv";
+
+    printf("Writing %d rows to \"%s\"...\n", rowCount, path.c_str());
+    double megabytes = writeTable(path, rowCount) / 1e6;
+
+    // the best of several runs; the first load of a Config object adds a slot for every flag,
+    // loading the file again only replaces the values
+    double bestFirst = 0.0;
+    double bestReload = 0.0;
+    size_t values = 0;
+    bool success = true;
+    for (int run = 0; run < runs; ++run) {
+        miniconf::Config conf;
+        conf.log(miniconf::Config::LogLevel::NONE);
+        auto begin = std::chrono::steady_clock::now();
+        success = conf.config(path) && success;
+        double first = secondsSince(begin);
+        begin = std::chrono::steady_clock::now();
+        success = conf.config(path) && success;
+        double reload = secondsSince(begin);
+        bestFirst = (run == 0) ? first : std::min(bestFirst, first);
+        bestReload = (run == 0) ? reload : std::min(bestReload, reload);
+
+        values = 0;
+        conf.forEach("", [&](const std::string&, miniconf::Value&) { ++values; });
+        success = success && (rowCount < 4 || conf["table3.label3"].getString() == "left, right \"3\"");
+    }
+
+    double splitBest = 0.0;
+    size_t fields = 0;
+    for (int run = 0; run < runs; ++run) {
+        auto begin = std::chrono::steady_clock::now();
+        std::ifstream file(path);
+        std::stringstream content;
+        content << file.rdbuf();
+        std::string line;
+        fields = 0;
+        while (std::getline(content, line)) {
+            std::stringstream lineStream(line);
+            std::string field;
+            while (std::getline(lineStream, field, ',')) {
+                ++fields;
+            }
+        }
+        double elapsed = secondsSince(begin);
+        splitBest = (run == 0) ? elapsed : std::min(splitBest, elapsed);
+    }
+
+    printf("%.1f MB, %d rows\n", megabytes, rowCount);
+    printf("  config(), first load:   %8.1f MB/s, %zu values, %s\n", megabytes / bestFirst, values, success ? "ok" : "failed");
+    printf("  config(), reload:       %8.1f MB/s\n", megabytes / bestReload);
+    printf("  stringstream split:     %8.1f MB/s, %zu fields, values not stored\n", megabytes / splitBest, fields);
+    remove(path.c_str());
+    return (success && values == static_cast<size_t>(rowCount)) ? 0 : 1;
+}
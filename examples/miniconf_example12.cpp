@@ -0,0 +1,85 @@
+/*
+ * miniconf example 12
+ *
+ * Timing durable snapshots of a configuration with 1000 values, as written
+ * after every change at runtime, next to serialize() which writes the file
+ * in place without syncing it.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+
+/* Prints the mean, median, 99th percentile and maximum of the latencies */
+static void report(const char* name, std::vector<double>& latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0.0;
+    for (double latency : latencies) {
+        total += latency;
+    }
+    size_t count = latencies.size();
+    printf("%-22s mean %8.3f ms, median %8.3f ms, p99 %8.3f ms, max %8.3f ms\n", name, total / count * 1e3,
+            latencies[count / 2] * 1e3, latencies[std::min(count - 1, count * 99 / 100)] * 1e3, latencies.back() * 1e3);
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int valueCount = (argc > 1) ? atoi(argv[1]) : 1000;
+    int writes = (argc > 2) ? atoi(argv[2]) : 200;
+    std::string path = "demo_snapshot";
+
+    miniconf::Config conf;
+    conf.log(miniconf::Config::LogLevel::NONE);
+    for (int i = 0; i < valueCount; ++i) {
+        std::string index = std::to_string(i);
+        switch (i % 3) {
+            case 0: conf.option("section" + std::to_string(i % 10) + ".number" + index).defaultValue(i * 0.5).required(false); break;
+            case 1: conf.option("section" + std::to_string(i % 10) + ".integer" + index).defaultValue(i).required(false); break;
+            default: conf.option("section" + std::to_string(i % 10) + ".name" + index).defaultValue("name " + index).required(false); break;
+        }
+    }
+    char* arguments[] = { argv[0] };
+    conf.parse(1, arguments);
+
+    const struct {
+        const char* name;
+        const char* extension;
+        miniconf::Config::ExportFormat format;
+    } formats[] = {
+        { "JSON", ".json", miniconf::Config::ExportFormat::JSON },
+        { "CSV", ".csv", miniconf::Config::ExportFormat::CSV },
+        { "BINARY", ".bin", miniconf::Config::ExportFormat::BINARY }
+    };
+
+    printf("%d values, %d writes each\n", valueCount, writes);
+    bool success = true;
+    for (auto& format : formats) {
+        std::string target = path + format.extension;
+        std::vector<double> snapshots;
+        std::vector<double> serializations;
+        for (int write = 0; write < writes; ++write) {
+            // a runtime change followed by a snapshot
+            conf["section1.integer1"] = write;
+            auto begin = std::chrono::steady_clock::now();
+            success = conf.snapshot(target, format.format) && success;
+            auto end = std::chrono::steady_clock::now();
+            snapshots.push_back(std::chrono::duration<double>(end - begin).count());
+
+            begin = std::chrono::steady_clock::now();
+            conf.serialize(target, format.format);
+            end = std::chrono::steady_clock::now();
+            serializations.push_back(std::chrono::duration<double>(end - begin).count());
+        }
+        report((std::string(format.name) + " snapshot()").c_str(), snapshots);
+        report((std::string(format.name) + " serialize()").c_str(), serializations);
+        remove(target.c_str());
+    }
+    return success ? 0 : 1;
+}
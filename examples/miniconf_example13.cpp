@@ -0,0 +1,252 @@
+/*
+ * miniconf example 13
+ *
+ * Writing config files and loading them back, and loading malformed ones.
+ * A file which cannot be parsed leaves the values as they were, a value
+ * which is rejected is skipped and the other values are loaded. The example
+ * exits with an error if a check fails.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <miniconf.h>
+
+static int failures = 0;
+
+/* Prints the result of a check and counts the failures */
+static void check(const char* name, bool passed)
+{
+    printf("%-52s %s\n", name, passed ? "ok" : "FAILED");
+    failures += passed ? 0 : 1;
+}
+
+/* Writes a config file */
+static void writeFile(const std::string& path, const std::string& content)
+{
+    FILE* fd = fopen(path.c_str(), "wb");
+    if (fd == nullptr) {
+        printf("unable to write %s\n", path.c_str());
+        exit(1);
+    }
+    fwrite(content.data(), 1, content.size(), fd);
+    fclose(fd);
+}
+
+/* Checks if the parse log of a Config contains a message */
+static bool logged(miniconf::Config& conf, const char* message)
+{
+    FILE* fd = tmpfile();
+    if (fd == nullptr) {
+        return false;
+    }
+    conf.log(fd);
+    std::string content(static_cast<size_t>(ftell(fd)), '\0');
+    rewind(fd);
+    content.resize(fread(&content[0], 1, content.size(), fd));
+    fclose(fd);
+    return content.find(message) != std::string::npos;
+}
+
+/* Defines the options of the checks */
+static void defineOptions(miniconf::Config& conf)
+{
+    conf.log(miniconf::Config::LogLevel::NONE);
+    conf.option("i").defaultValue(1).required(false);
+    conf.option("j").defaultValue(2).required(false);
+    conf.option("s").defaultValue("default").required(false);
+}
+
+/* Main file */
+int main()
+{
+    // a JSON file with a syntax error halfway through loads nothing
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        writeFile("demo_malformed.json", "{ \"i\": 5, \"j\": 6, \"s\": \"json\" }");
+        bool loaded = conf.config("demo_malformed.json");
+        writeFile("demo_malformed.json", "{ \"i\": 7, \"j\": ");
+        bool truncated = conf.config("demo_malformed.json");
+        check("truncated JSON file leaves the values unchanged", loaded && !truncated
+                && conf["i"].getInt() == 5 && conf["j"].getInt() == 6 && conf["s"].getString() == "json");
+    }
+
+    // malformed CSV lines are reported, an unterminated quote fails the whole file
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        conf.log(miniconf::Config::LogLevel::WARNING);
+        writeFile("demo_malformed.csv", "i,5\ns,\"unterminated\ni,8\n");
+        bool unterminated = conf.config("demo_malformed.csv");
+        check("CSV unterminated quoted field is rejected", !unterminated && !conf.contains("i")
+                && logged(conf, "unterminated quoted field, the rest of the file is not loaded, line 2"));
+    }
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        conf.log(miniconf::Config::LogLevel::WARNING);
+        writeFile("demo_malformed.csv", "s,\"q\" trailing\r\ni,8\r\n");
+        bool loaded = conf.config("demo_malformed.csv");
+        check("CSV text after a closing quote is reported", loaded && conf["s"].getString() == "q"
+                && conf["i"].getInt() == 8 && logged(conf, "text after a closing quote is ignored, line 1"));
+    }
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        conf.log(miniconf::Config::LogLevel::WARNING);
+        writeFile("demo_malformed.csv", "i,5,\nj\ns,\"quoted\"\r\n");
+        bool loaded = conf.config("demo_malformed.csv");
+        check("CSV line without a value is reported", loaded && conf["i"].getInt() == 5 && conf["s"].getString() == "quoted"
+                && logged(conf, "no value is provided, line 2") && !logged(conf, "line 1") && !logged(conf, "line 3"));
+    }
+
+    // a number with a fraction is rejected for an integer option by both JSON parsers
+    {
+        miniconf::Config::JSONParser parsers[] = { miniconf::Config::JSONParser::PICOJSON, miniconf::Config::JSONParser::SCALAR };
+        bool rejected = true;
+        for (miniconf::Config::JSONParser parser : parsers) {
+            miniconf::Config conf;
+            defineOptions(conf);
+            conf.log(miniconf::Config::LogLevel::WARNING);
+            conf.jsonParser(parser);
+            writeFile("demo_malformed.json", "{ \"i\": 1.5 }");
+            bool fraction = conf.config("demo_malformed.json");
+            writeFile("demo_malformed.json", "{ \"i\": 2.0, \"j\": 3e1 }");
+            bool integral = conf.config("demo_malformed.json");
+            rejected = rejected && !fraction && integral && conf["i"].getInt() == 2 && conf["j"].getInt() == 30
+                    && logged(conf, "the value is not an integer or out of range");
+        }
+        check("JSON number with a fraction for an INT option", rejected);
+    }
+
+    // a rejected value is skipped by both JSON parsers, the other values of the file are loaded,
+    // a null of a flag which is not an option is skipped with a warning only
+    {
+        miniconf::Config::JSONParser parsers[] = { miniconf::Config::JSONParser::PICOJSON, miniconf::Config::JSONParser::SCALAR };
+        bool skipped = true;
+        for (miniconf::Config::JSONParser parser : parsers) {
+            miniconf::Config conf;
+            defineOptions(conf);
+            conf.log(miniconf::Config::LogLevel::WARNING);
+            conf.jsonParser(parser);
+            const char* arguments[] = { "app" };
+            conf.parse(1, const_cast<char**>(arguments));
+            writeFile("demo_malformed.json", "{ \"i\": 9, \"note\": null }");
+            bool stray = conf.config("demo_malformed.json");
+            int strayValue = conf["i"].getInt();
+            writeFile("demo_malformed.json", "{ \"i\": null, \"j\": 4, \"s\": 5 }");
+            bool rejected = conf.config("demo_malformed.json");
+            skipped = skipped && stray && strayValue == 9 && !conf.contains("note") && logged(conf, "null value is skipped")
+                    && !rejected && conf["i"].getInt() == 1 && conf["j"].getInt() == 4 && conf["s"].getString() == "default";
+        }
+        check("JSON rejected values are skipped one by one", skipped);
+    }
+
+    // a directory is loaded like a single file, a rejected value is skipped and a file which
+    // cannot be parsed leaves the values of the directory unchanged
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        const char* arguments[] = { "app" };
+        conf.parse(1, const_cast<char**>(arguments));
+        mkdir("demo_malformed.d", 0755);
+        writeFile("demo_malformed.d/10-base.json", "{ \"i\": 5, \"s\": \"base\" }");
+        writeFile("demo_malformed.d/20-local.csv", "j,text\ns,local\n");
+        bool rejected = conf.configDirectory("demo_malformed.d");
+        bool skipped = !rejected && conf["i"].getInt() == 5 && conf["j"].getInt() == 2 && conf["s"].getString() == "local";
+        writeFile("demo_malformed.d/20-local.csv", "j,7\ns,\"unterminated\n");
+        bool malformed = conf.configDirectory("demo_malformed.d");
+        check("conf.d rejected value and malformed file", skipped && !malformed
+                && conf["i"].getInt() == 5 && conf["j"].getInt() == 2 && conf["s"].getString() == "local");
+    }
+
+    // the file keeps its layer when it is replaced by a file which fails to load, so the
+    // values it provided do not fall back to the defaults
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        writeFile("demo_layer.json", "{ \"i\": 5, \"s\": \"json\" }");
+        bool loaded = conf.config("demo_layer.json");
+        writeFile("demo_layer.json", "{ \"i\": 7 ");
+        bool truncated = conf.config("demo_layer.json");
+        writeFile("demo_layer.json", std::string("MINICONF\0\0\0\0", 12));
+        bool corrupt = conf.config("demo_layer.json");
+        check("failed loads keep the layer of the file", loaded && !truncated && !corrupt
+                && conf["i"].getInt() == 5 && conf["s"].getString() == "json"
+                && conf.source("i") == miniconf::Config::Source::FILE && conf.sourceName("s") == "demo_layer.json");
+    }
+
+    // infinity and NaN are written to JSON as strings and loaded back by both JSON parsers,
+    // the other values of the file are not affected
+    {
+        miniconf::Config::JSONParser parsers[] = { miniconf::Config::JSONParser::PICOJSON, miniconf::Config::JSONParser::SCALAR };
+        bool restored = true;
+        for (miniconf::Config::JSONParser parser : parsers) {
+            miniconf::Config conf;
+            conf.log(miniconf::Config::LogLevel::NONE);
+            conf.option("a").defaultValue(0.5).required(false);
+            conf.option("b").defaultValue(5).required(false);
+            conf.option("w").defaultValue(std::vector<double>{ 1.0 }).required(false);
+            conf.option("v").defaultValue(std::vector<double>{ 1.0 }).required(false);
+            const char* arguments[] = { "app", "--a", "nan", "--b", "7", "--w", "1.5,-inf", "--v", "nan,inf" };
+            conf.parse(9, const_cast<char**>(arguments));
+            conf.serialize("demo_nonfinite.json", miniconf::Config::ExportFormat::JSON);
+
+            miniconf::Config reloaded;
+            reloaded.log(miniconf::Config::LogLevel::NONE);
+            reloaded.jsonParser(parser);
+            reloaded.option("a").defaultValue(0.5).required(false);
+            reloaded.option("b").defaultValue(5).required(false);
+            reloaded.option("w").defaultValue(std::vector<double>{ 1.0 }).required(false);
+            reloaded.option("v").defaultValue(std::vector<double>{ 1.0 }).required(false);
+            const char* reload[] = { "app", "--config", "demo_nonfinite.json" };
+            bool parsed = reloaded.parse(3, const_cast<char**>(reload));
+            miniconf::Value::Array<double> w = reloaded["w"].getNumberArray();
+            miniconf::Value::Array<double> v = reloaded["v"].getNumberArray();
+            restored = restored && parsed && std::isnan(reloaded["a"].getNumber()) && reloaded["b"].getInt() == 7
+                    && w.size() == 2 && w[0] == 1.5 && w[1] == -INFINITY
+                    && v.size() == 2 && std::isnan(v[0]) && v[1] == INFINITY;
+        }
+        check("JSON round trip of infinity and NaN", restored);
+    }
+
+    // serializing over the binary snapshot which was just loaded, "k" is not defined by the
+    // program reading it, so its entry is still mapped when the file is opened for writing
+    {
+        miniconf::Config conf;
+        defineOptions(conf);
+        conf.option("k").defaultValue(3).required(false);
+        writeFile("demo_snapshot.json", "{ \"i\": 5, \"s\": \"json\" }");
+        const char* arguments[] = { "app" };
+        conf.parse(1, const_cast<char**>(arguments));
+        conf.config("demo_snapshot.json");
+        conf.serialize("demo_snapshot.bin", miniconf::Config::ExportFormat::BINARY);
+
+        miniconf::Config reloaded;
+        defineOptions(reloaded);
+        bool loaded = reloaded.config("demo_snapshot.bin");
+        reloaded.serialize("demo_snapshot.bin", miniconf::Config::ExportFormat::BINARY);
+        miniconf::Config again;
+        again.log(miniconf::Config::LogLevel::NONE);
+        bool reread = again.config("demo_snapshot.bin");
+        check("serialize() over the attached snapshot", loaded && reread
+                && reloaded["k"].getInt() == 3 && again["i"].getInt() == 5 && again["k"].getInt() == 3
+                && again["s"].getString() == "json");
+    }
+
+    remove("demo_malformed.json");
+    remove("demo_malformed.csv");
+    remove("demo_snapshot.json");
+    remove("demo_snapshot.bin");
+    remove("demo_layer.json");
+    remove("demo_nonfinite.json");
+    remove("demo_malformed.d/10-base.json");
+    remove("demo_malformed.d/20-local.csv");
+    remove("demo_malformed.d");
+    return (failures == 0) ? 0 : 1;
+}
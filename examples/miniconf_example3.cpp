@@ -0,0 +1,77 @@
+/*
+ * miniconf example 3
+ *
+ * Loading a conf.d directory of config fragments, and timing the load
+ * with an increasing number of threads.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <miniconf.h>
+
+/* Writes "fileCount" fragments with "valueCount" values each, every second one is a CSV file */
+static void writeFragments(const std::string& directory, int fileCount, int valueCount)
+{
+    mkdir(directory.c_str(), 0755);
+    for (int file = 0; file < fileCount; ++file) {
+        char name[64];
+        bool csv = (file % 2 == 1);
+        snprintf(name, sizeof(name), "/%03d-fragment.%s", file, csv ? "csv" : "json");
+        FILE* fd = fopen((directory + name).c_str(), "w");
+        if (fd == nullptr) {
+            continue;
+        }
+        fprintf(fd, csv ? "" : "{\n");
+        for (int value = 0; value < valueCount; ++value) {
+            // every fragment overrides "part1.value1", the last file wins
+            if (csv && file == 1 && value == 1) {
+                // "part1.value1" is an INT option, a number would be rejected
+                fprintf(fd, "part%d.value%d,%d\n", file, value, value);
+            } else if (csv) {
+                fprintf(fd, "part%d.value%d,%d.5\n", file, value, value);
+            } else {
+                fprintf(fd, "  \"part%d\": {\"value%d\": \"text %d\"},\n", file, value, value);
+            }
+        }
+        fprintf(fd, csv ? "part1.value1,%d\n" : "  \"part1\": {\"value1\": %d}\n}\n", file);
+        fclose(fd);
+    }
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int fileCount = (argc > 1) ? atoi(argv[1]) : 64;
+    int valueCount = (argc > 2) ? atoi(argv[2]) : 20000;
+    std::string directory = "demo_conf.d";
+
+    printf("Writing %d fragments with %d values each to \"%s\"...\n", fileCount, valueCount, directory.c_str());
+    writeFragments(directory, fileCount, valueCount);
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; ; threads *= 2) {
+        threads = std::min(threads, cores);
+
+        // options define the data types of the values loaded from the fragments
+        miniconf::Config conf;
+        conf.option("part1.value1").shortflag("p1v1").defaultValue(0).required(false).description("Overridden by every fragment");
+        conf.log(miniconf::Config::LogLevel::WARNING);
+
+        auto begin = std::chrono::steady_clock::now();
+        bool success = conf.configDirectory(directory, threads);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        printf("%2u thread(s): %.3f s, %s, part1.value1 = %d (from %s)\n", threads, elapsed,
+                success ? "ok" : "failed", conf["part1.value1"].getInt(), conf.sourceName("part1.value1").c_str());
+        if (threads == cores) {
+            break;
+        }
+    }
+    return 0;
+}
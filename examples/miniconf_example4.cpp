@@ -0,0 +1,75 @@
+/*
+ * miniconf example 4
+ *
+ * Loading a large JSON config file with picojson and with the structural
+ * parser on every instruction set, and timing each parser.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <miniconf.h>
+
+/* Writes "sectionCount" sections with "valueCount" values of every type each, returns the file size */
+static long writeConfig(const std::string& path, int sectionCount, int valueCount)
+{
+    FILE* fd = fopen(path.c_str(), "w");
+    if (fd == nullptr) {
+        return 0;
+    }
+    fprintf(fd, "{\n");
+    for (int section = 0; section < sectionCount; ++section) {
+        fprintf(fd, "  \"section%d\": {\n", section);
+        for (int value = 0; value < valueCount; ++value) {
+            fprintf(fd, "    \"integer%d\": %d,\n", value, section * valueCount + value);
+            fprintf(fd, "    \"number%d\": %d.%04d,\n", value, value, section);
+            fprintf(fd, "    \"text%d\": \"value \\\"%d\\\" of section %d\",\n", value, value, section);
+            fprintf(fd, "    \"flag%d\": %s,\n", value, (value % 2 == 0) ? "true" : "false");
+            fprintf(fd, "    \"list%d\": [%d, %d, %d],\n", value, value, value + 1, value + 2);
+        }
+        fprintf(fd, "    \"name\": \"section %d\"\n  }%s\n", section, (section + 1 < sectionCount) ? "," : "");
+    }
+    fprintf(fd, "}\n");
+    long size = ftell(fd);
+    fclose(fd);
+    return size;
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int sectionCount = (argc > 1) ? atoi(argv[1]) : 200;
+    int valueCount = (argc > 2) ? atoi(argv[2]) : 200;
+    int repeat = (argc > 3) ? atoi(argv[3]) : 5;
+    std::string path = "demo_large.json";
+
+    long size = writeConfig(path, sectionCount, valueCount);
+    printf("Wrote %.1f MB to \"%s\"\n", size / 1048576.0, path.c_str());
+
+    struct { miniconf::Config::JSONParser parser; const char* name; } parsers[] = {
+        { miniconf::Config::JSONParser::PICOJSON, "picojson" },
+        { miniconf::Config::JSONParser::SCALAR, "structural, scalar" },
+        { miniconf::Config::JSONParser::SSE2, "structural, SSE2" },
+        { miniconf::Config::JSONParser::AVX2, "structural, AVX2" },
+        { miniconf::Config::JSONParser::AUTO, "structural, auto" }
+    };
+    for (const auto& parser : parsers) {
+        // the first run creates the flags of the values, the following runs reload the file
+        miniconf::Config conf;
+        conf.log(miniconf::Config::LogLevel::WARNING);
+        conf.jsonParser(parser.parser);
+
+        double best = 0.0;
+        bool success = true;
+        for (int run = 0; run < repeat; ++run) {
+            auto begin = std::chrono::steady_clock::now();
+            success = conf.config(path) && success;
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            best = (run == 0) ? elapsed : std::min(best, elapsed);
+        }
+        printf("%-20s %.3f s, %7.1f MB/s, %s, section1.text1 = %s\n", parser.name, best, size / 1048576.0 / best,
+                success ? "ok" : "failed", conf["section1.text1"].getString().c_str());
+    }
+    return 0;
+}
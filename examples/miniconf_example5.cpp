@@ -0,0 +1,53 @@
+/*
+ * miniconf example 5
+ *
+ * Counting the heap allocations of parsing a command line. Once the options
+ * are defined and a first command line has been parsed, parsing a command
+ * line without errors allocates nothing beyond values which do not fit into
+ * a Value (long strings and arrays). The example exits with an error if it does.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <miniconf.h>
+#include "miniconf_allocations.h"
+
+/* Main file */
+int main()
+{
+    miniconf::Config conf;
+    conf.description("Counting the allocations of parse()");
+    conf.option("numOpt").shortflag("n").defaultValue(3.14).required(false).description("A number value");
+    conf.option("intOpt").shortflag("d").defaultValue(122).required(false).description("A integer value");
+    conf.option("bigOpt").shortflag("g").defaultValue(static_cast<int64_t>(1)).required(false).description("A 64-bit integer value");
+    conf.option("boolOpt").shortflag("b").defaultValue(false).required(false).description("A boolean value");
+    conf.option("strOpt").shortflag("s").defaultValue("string").required(false).description("A short string value");
+    conf.option("part1.value1").shortflag("p1").defaultValue(1).required(false).description("A nested value");
+
+    // short strings are stored within the Value, like the scalars
+    const char* arguments[] = {
+        "/usr/bin/app", "--numOpt", "2.5", "-d", "7", "--bigOpt", "123456789012345678",
+        "-b", "--strOpt", "hello", "--part1.value1", "-3"
+    };
+    int argumentCount = static_cast<int>(sizeof(arguments) / sizeof(arguments[0]));
+    char** argv = const_cast<char**>(arguments);
+
+    // the first parse sizes the buffers of the option store and its source layers
+    if (!conf.parse(argumentCount, argv)) {
+        conf.log();
+        return 1;
+    }
+
+    unsigned long failures = 0;
+    for (int run = 0; run < 3; ++run) {
+        unsigned long before = allocations.load();
+        bool success = conf.parse(argumentCount, argv);
+        unsigned long count = allocations.load() - before;
+        printf("parse %d: %s, %lu allocation(s)\n", run + 1, success ? "ok" : "failed", count);
+        failures += (success && count == 0) ? 0 : 1;
+    }
+    printf("intOpt = %d, bigOpt = %lld, strOpt = %s\n", conf["intOpt"].getInt(),
+            static_cast<long long>(conf["bigOpt"].getInt64()), conf["strOpt"].getCharArray());
+    return (failures == 0) ? 0 : 1;
+}
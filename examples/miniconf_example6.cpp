@@ -0,0 +1,85 @@
+/*
+ * miniconf example 6
+ *
+ * Reading published snapshots from 1 to 64 threads while the main thread
+ * keeps publishing new values, and timing acquire() and publish().
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <miniconf.h>
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int maxReaders = (argc > 1) ? atoi(argv[1]) : 64;
+    double seconds = (argc > 2) ? atof(argv[2]) : 0.25;
+
+    miniconf::Config conf;
+    conf.option("first").defaultValue(0).required(false).description("Published together with \"second\"");
+    conf.option("second").defaultValue(0).required(false).description("Published together with \"first\"");
+    for (int i = 0; i < 100; ++i) {
+        conf.option("part" + std::to_string(i / 10) + ".value" + std::to_string(i)).defaultValue(i).required(false);
+    }
+    conf.log(miniconf::Config::LogLevel::WARNING);
+    char* arguments[] = { argv[0] };
+    conf.parse(1, arguments);
+    conf.publish();
+
+    unsigned long long totalTorn = 0;
+    for (int readers = 1; readers <= maxReaders; readers *= 2) {
+        std::atomic<bool> running(true);
+        std::atomic<unsigned long long> acquires(0);
+        std::atomic<unsigned long long> torn(0);
+
+        // every reader checks that "first" and "second" come from the same publish()
+        std::vector<std::thread> threads;
+        for (int reader = 0; reader < readers; ++reader) {
+            threads.emplace_back([&]() {
+                unsigned long long count = 0;
+                unsigned long long mismatches = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    miniconf::ConfigSnapshot::Guard snapshot = conf.acquire();
+                    if ((*snapshot)["first"].getInt() != (*snapshot)["second"].getInt()) {
+                        ++mismatches;
+                    }
+                    ++count;
+                }
+                acquires.fetch_add(count);
+                torn.fetch_add(mismatches);
+            });
+        }
+
+        // the main thread publishes as fast as it can
+        unsigned long long publishes = 0;
+        double worstPublish = 0.0;
+        auto begin = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        while (elapsed < seconds) {
+            conf["first"] = static_cast<int>(publishes);
+            conf["second"] = static_cast<int>(publishes);
+            auto before = std::chrono::steady_clock::now();
+            conf.publish();
+            auto after = std::chrono::steady_clock::now();
+            worstPublish = std::max(worstPublish, std::chrono::duration<double>(after - before).count());
+            elapsed = std::chrono::duration<double>(after - begin).count();
+            ++publishes;
+        }
+        running = false;
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        printf("%2d reader(s): %7.2f M acquire/s (%6.2f M per reader), %6llu publish/s (worst %7.1f us), %llu torn read(s)\n",
+                readers, acquires.load() / elapsed / 1e6, acquires.load() / elapsed / 1e6 / readers,
+                static_cast<unsigned long long>(publishes / elapsed), worstPublish * 1e6, torn.load());
+        totalTorn += torn.load();
+    }
+    return (totalTorn == 0) ? 0 : 1;
+}
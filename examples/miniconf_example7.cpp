@@ -0,0 +1,66 @@
+/*
+ * miniconf example 7
+ *
+ * Counting the heap allocations of scalar Values. Integers, numbers,
+ * booleans and strings of up to Value::INLINE_CAPACITY characters are
+ * stored within the Value, so constructing, copying, moving and assigning
+ * them allocates nothing. The example exits with an error if it does.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <miniconf.h>
+#include "miniconf_allocations.h"
+
+/* Constructs, copies, moves and assigns a value "rounds" times, returns the allocations per round */
+static double countAllocations(const char* name, const miniconf::Value& value, int rounds, double& checksum)
+{
+    unsigned long before = allocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        miniconf::Value copy(value);
+        miniconf::Value moved(std::move(copy));
+        miniconf::Value assigned;
+        assigned = moved;
+        assigned = std::move(moved);
+        checksum += assigned.size();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    double perRound = static_cast<double>(allocations.load() - before) / rounds;
+    printf("%-14s %6.2f allocation(s) per round, %6.1f ns per round\n", name, perRound, elapsed / rounds * 1e9);
+    return perRound;
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int rounds = (argc > 1) ? atoi(argv[1]) : 1000000;
+    double checksum = 0.0;
+
+    // a round is a copy construction, a move construction, a copy assignment and a move assignment
+    unsigned long before = allocations.load();
+    miniconf::Value intValue(42);
+    miniconf::Value int64Value(static_cast<int64_t>(1) << 40);
+    miniconf::Value numberValue(3.14);
+    miniconf::Value boolValue(true);
+    miniconf::Value shortString("a short string");
+    unsigned long constructed = allocations.load() - before;
+    printf("%-14s %6lu allocation(s) for 5 values\n", "construction", constructed);
+
+    double scalars = 0.0;
+    scalars += countAllocations("int", intValue, rounds, checksum);
+    scalars += countAllocations("int64", int64Value, rounds, checksum);
+    scalars += countAllocations("number", numberValue, rounds, checksum);
+    scalars += countAllocations("bool", boolValue, rounds, checksum);
+    scalars += countAllocations("short string", shortString, rounds, checksum);
+
+    // for comparison, strings which do not fit into the value are copied to the heap
+    miniconf::Value longString("a string which is too long to be stored inline");
+    countAllocations("long string", longString, rounds, checksum);
+
+    printf("checksum %.0f\n", checksum);
+    return (constructed == 0 && scalars == 0.0) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+/*
+ * miniconf example 8
+ *
+ * Timing flag lookups and full scans of the option store with 10, 1k and
+ * 100k options, next to a std::map holding the same values.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    // every size is looked up and scanned about the same number of times in total
+    long operations = (argc > 1) ? atol(argv[1]) : 2000000;
+    const int sizes[] = { 10, 1000, 100000 };
+
+    printf("%8s %14s %14s %14s %14s\n", "options", "lookup (ns)", "map lookup", "scan (ns/val)", "map scan");
+    long long checksum = 0;
+    for (int size : sizes) {
+        miniconf::Config conf;
+        std::map<std::string, miniconf::Value> reference;
+        std::vector<std::string> flags;
+        for (int i = 0; i < size; ++i) {
+            flags.push_back("section" + std::to_string(i % 97) + ".value" + std::to_string(i));
+            conf.option(flags.back()).defaultValue(i).required(false).description("A value");
+            reference[flags.back()] = miniconf::Value(i);
+        }
+        conf.log(miniconf::Config::LogLevel::NONE);
+        char* arguments[] = { argv[0] };
+        conf.parse(1, arguments);
+
+        // lookups in random order, so the store cannot be walked sequentially
+        std::mt19937 random(size);
+        std::shuffle(flags.begin(), flags.end(), random);
+        long lookups = std::max(operations, static_cast<long>(size));
+
+        auto begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < lookups; ++i) {
+            checksum += conf[flags[i % size]].getInt();
+        }
+        double lookupTime = secondsSince(begin) / lookups;
+
+        begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < lookups; ++i) {
+            checksum += reference[flags[i % size]].getInt();
+        }
+        double mapLookupTime = secondsSince(begin) / lookups;
+
+        // full scans visit every value
+        long scans = std::max(1L, operations / size);
+        begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < scans; ++i) {
+            conf.forEach("", [&](const std::string&, miniconf::Value& value) {
+                checksum += value.getInt();
+            });
+        }
+        double scanTime = secondsSince(begin) / (scans * size);
+
+        begin = std::chrono::steady_clock::now();
+        for (long i = 0; i < scans; ++i) {
+            for (auto& entry : reference) {
+                checksum += entry.second.getInt();
+            }
+        }
+        double mapScanTime = secondsSince(begin) / (scans * size);
+
+        printf("%8d %14.1f %14.1f %14.1f %14.1f\n", size, lookupTime * 1e9, mapLookupTime * 1e9,
+                scanTime * 1e9, mapScanTime * 1e9);
+    }
+    printf("checksum %lld\n", checksum);
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * miniconf example 9
+ *
+ * Timing the startup of a program with a generated schema of 5k options:
+ * defining the options, checking their format and parsing the command
+ * line. For comparison, the pairwise duplicate short flag check which
+ * checkFormat() used to run is timed through the public accessors.
+ *
+ * author: Tsz-Ho Yu (tszhoyu@gmail.com)
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <miniconf.h>
+
+static double secondsSince(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+/* Main file */
+int main(int argc, char** argv)
+{
+    int optionCount = (argc > 1) ? atoi(argv[1]) : 5000;
+
+    miniconf::Config conf;
+    conf.description("A generated schema");
+    conf.log(miniconf::Config::LogLevel::NONE);
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<miniconf::Config::Option*> options;
+    for (int i = 0; i < optionCount; ++i) {
+        std::string index = std::to_string(i);
+        options.push_back(&conf.option("module" + std::to_string(i % 50) + ".option" + index)
+                .shortflag("o" + index).defaultValue(i).required(false).description("Generated option " + index));
+    }
+    double defineTime = secondsSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    miniconf::Config::LogLevel format = conf.checkFormat();
+    double checkTime = secondsSince(begin);
+
+    begin = std::chrono::steady_clock::now();
+    char* arguments[] = { argv[0] };
+    bool success = conf.parse(1, arguments);
+    double parseTime = secondsSince(begin);
+
+    // the check of every pair of options done by checkFormat() before it was made incremental
+    begin = std::chrono::steady_clock::now();
+    size_t duplicates = 0;
+    for (miniconf::Config::Option* option : options) {
+        for (miniconf::Config::Option* other : options) {
+            if (option->flag() != other->flag() && option->shortflag() == other->shortflag() && !option->shortflag().empty()) {
+                ++duplicates;
+            }
+        }
+    }
+    double pairwiseTime = secondsSince(begin);
+
+    printf("%d options\n", optionCount);
+    printf("  define options:         %9.3f ms\n", defineTime * 1e3);
+    printf("  checkFormat():          %9.3f ms, %s\n", checkTime * 1e3,
+            format >= miniconf::Config::LogLevel::ERROR ? "errors" : "ok");
+    printf("  parse():                %9.3f ms, %s\n", parseTime * 1e3, success ? "ok" : "failed");
+    printf("  pairwise short flags:   %9.3f ms, %zu duplicate(s), no longer run\n", pairwiseTime * 1e3, duplicates);
+    return success ? 0 : 1;
+}
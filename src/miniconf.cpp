@@ -9,32 +9,134 @@
 
 #include "miniconf.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <clocale>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#ifdef MINICONF_JSON_SUPPORT
+// integers in JSON files are parsed exactly instead of as doubles; picojson is only included
+// here, so the definition does not depend on what a program includes before miniconf.h
+#ifndef PICOJSON_USE_INT64
+#define PICOJSON_USE_INT64
+#endif
+#include "picojson.h"
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MINICONF_MMAP_SUPPORT
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MINICONF_FSYNC_SUPPORT
+#include <libgen.h>
+#define MINICONF_DIRECTORY_SUPPORT
+#include <dirent.h>
+#endif
+
+#if defined(_WIN32)
+// MoveFileExA() replaces a snapshot atomically, _commit() flushes it to disk
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#endif
+
+// strtod_l() converts numbers in the "C" locale without touching the global locale
+#if defined(_WIN32) || defined(__GLIBC__) || defined(__APPLE__) || defined(__FreeBSD__)
+#define MINICONF_STRTOD_L_SUPPORT
+#include <locale.h>
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <xlocale.h>
+#endif
+#endif
+
+#if defined(MINICONF_JSON_SUPPORT) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define MINICONF_SIMD_SUPPORT
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__)
+#define MINICONF_INOTIFY_SUPPORT
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+// the environment of the process, scanned by Config::environment()
+#if defined(_WIN32)
+#define MINICONF_ENVIRON _environ
+#else
+extern char** environ;
+#define MINICONF_ENVIRON environ
+#endif
+
 namespace miniconf {
 
     // Value
-    Value::Value() : _type(DataType::UNKNOWN), _size(0), _data(nullptr)
+    const size_t Value::INLINE_CAPACITY;
+
+    Value::Value() : _type(DataType::UNKNOWN), _size(0), _number(0.0)
     {}
 
     Value::Value(const Value& other) : Value()
     {
-        copyData(other._data, other._size, other._type);
+        if (other.isArray()) {
+            copyArray(other);
+        } else if (other.isHeap()) {
+            copyString(other._heap, other._size);
+        } else {
+            // scalars and inline strings are trivially copyable
+            memcpy(static_cast<void*>(this), static_cast<const void*>(&other), sizeof(Value));
+        }
     }
 
     Value::Value(Value&& other) : Value()
     {
-        moveData(other._data, other._size, other._type);
+        moveData(other);
     }
 
 
     Value& Value::operator=(const Value& other)
     {
+        if (this == &other) {
+            return *this;
+        }
         clearData();
-        return copyData(other._data, other._size, other._type);
+        if (other.isArray()) {
+            return copyArray(other);
+        }
+        if (other.isHeap()) {
+            return copyString(other._heap, other._size);
+        }
+        memcpy(static_cast<void*>(this), static_cast<const void*>(&other), sizeof(Value));
+        return *this;
     }
 
     Value& Value::operator=(Value&& other)
     {
-        return moveData(other._data, other._size, other._type);
+        if (this == &other) {
+            return *this;
+        }
+        clearData();
+        return moveData(other);
     }
 
     Value::~Value()
@@ -45,116 +147,271 @@ namespace miniconf {
     //  int
     Value::Value(const int& other) : Value()
     {
-        copyData(reinterpret_cast<const char*>(&other), sizeof(int), DataType::INT);
+        _type = DataType::INT;
+        _int = other;
     }
 
     Value& Value::operator=(const int& other)
     {
         clearData();
-        return copyData(reinterpret_cast<const char*>(&other), sizeof(int), DataType::INT);
+        _type = DataType::INT;
+        _int = other;
+        return *this;
     }
 
     Value::operator int() const
     {
-        return *reinterpret_cast<int*>(_data);
+        return _int;
     }
 
     int Value::getInt() const
     {
-        return *reinterpret_cast<int*>(_data);
+        return _int;
+    }
+
+    //  64-bit int
+    Value::Value(const int64_t& other) : Value()
+    {
+        _type = DataType::INT64;
+        _int64 = other;
+    }
+
+    Value& Value::operator=(const int64_t& other)
+    {
+        clearData();
+        _type = DataType::INT64;
+        _int64 = other;
+        return *this;
+    }
+
+    Value::operator int64_t() const
+    {
+        return _int64;
+    }
+
+    int64_t Value::getInt64() const
+    {
+        return _int64;
     }
 
     //  number (floating point)
     Value::Value(const double& other) : Value()
     {
-        copyData(reinterpret_cast<const char*>(&other), sizeof(double), DataType::NUMBER);
+        _type = DataType::NUMBER;
+        _number = other;
     }
 
     Value& Value::operator=(const double& other)
     {
         clearData();
-        return copyData(reinterpret_cast<const char*>(&other), sizeof(double), DataType::NUMBER);
+        _type = DataType::NUMBER;
+        _number = other;
+        return *this;
     }
 
     Value::operator double() const
     {
-        return *reinterpret_cast<double*>(_data);
+        return _number;
     }
 
     double Value::getNumber() const
     {
-        return *reinterpret_cast<double*>(_data);
+        return _number;
     }
 
 
     //  bool
     Value::Value(const bool& other) : Value()
     {
-        copyData(reinterpret_cast<const char*>(&other), sizeof(bool), DataType::BOOL);
+        _type = DataType::BOOL;
+        _bool = other;
     }
 
     Value& Value::operator=(const bool& other)
     {
         clearData();
-        return copyData(reinterpret_cast<const char*>(&other), sizeof(bool), DataType::BOOL);
+        _type = DataType::BOOL;
+        _bool = other;
+        return *this;
     }
 
     Value::operator bool() const
     {
-        return *reinterpret_cast<bool*>(_data);
+        return _bool;
     }
 
     bool Value::getBoolean() const
     {
-        return *reinterpret_cast<bool*>(_data);
+        return _bool;
     }
 
     //  char array
     Value::Value(const char* other) : Value()
     {
-        copyData(other, strlen(other) + 1, DataType::STRING);
+        copyString(other, strlen(other));
     }
 
     Value& Value::operator=(const char* other)
     {
-        clearData();
-        return copyData(other, strlen(other) + 1, DataType::STRING);
+        // the source may point into our own buffer, copy before releasing it
+        Value temp(other);
+        return *this = std::move(temp);
     }
 
     Value::operator char*() const
     {
-        return reinterpret_cast<char*>(_data);
+        return getCharArray();
     }
 
     char* Value::getCharArray() const
     {
-        return reinterpret_cast<char*>(_data);
+        if (_type != DataType::STRING) {
+            return nullptr;
+        }
+        return const_cast<char*>(stringData());
     }
 
     //  std::string
     Value::Value(const std::string& other) : Value()
     {
-        copyData(other.c_str(), other.size() + 1, DataType::STRING);
+        copyString(other.c_str(), other.size());
+    }
+
+    Value::Value(const char* other, size_t length) : Value()
+    {
+        copyString(other, length);
     }
 
     Value& Value::operator=(const std::string& other)
     {
         clearData();
-        return copyData(other.c_str(), other.size() + 1, DataType::STRING);
+        return copyString(other.c_str(), other.size());
     }
 
     Value::operator std::string() const
     {
-        return std::string(reinterpret_cast<char*>(_data));
+        return getString();
     }
 
     std::string Value::getString() const
     {
-        return std::string(reinterpret_cast<char*>(_data));
+        if (_type != DataType::STRING) {
+            return print();
+        }
+        return std::string(getCharArray(), _size);
+    }
+
+    //  arrays
+    Value::Value(const std::vector<int>& other) : Value()
+    {
+        char* data = allocateArray(DataType::INT_ARRAY, other.size(), other.size() * sizeof(int));
+        if (!other.empty()) {
+            memcpy(data, other.data(), other.size() * sizeof(int));
+        }
+    }
+
+    Value::Value(const std::vector<double>& other) : Value()
+    {
+        char* data = allocateArray(DataType::NUMBER_ARRAY, other.size(), other.size() * sizeof(double));
+        if (!other.empty()) {
+            memcpy(data, other.data(), other.size() * sizeof(double));
+        }
+    }
+
+    Value::Value(const std::vector<bool>& other) : Value()
+    {
+        bool* data = reinterpret_cast<bool*>(allocateArray(DataType::BOOL_ARRAY, other.size(), other.size() * sizeof(bool)));
+        for (size_t i = 0; i < other.size(); ++i) {
+            data[i] = other[i];
+        }
+    }
+
+    Value::Value(const std::vector<std::string>& other) : Value()
+    {
+        // one pointer per element, followed by the null-terminated strings
+        size_t bytes = other.size() * sizeof(const char*);
+        for (const std::string& str : other) {
+            bytes += str.size() + 1;
+        }
+        char* data = allocateArray(DataType::STRING_ARRAY, other.size(), bytes);
+        const char** pointers = reinterpret_cast<const char**>(data);
+        char* chars = data + other.size() * sizeof(const char*);
+        for (size_t i = 0; i < other.size(); ++i) {
+            memcpy(chars, other[i].c_str(), other[i].size() + 1);
+            pointers[i] = chars;
+            chars += other[i].size() + 1;
+        }
+    }
+
+    Value& Value::operator=(const std::vector<int>& other)
+    {
+        return *this = Value(other);
+    }
+
+    Value& Value::operator=(const std::vector<double>& other)
+    {
+        return *this = Value(other);
+    }
+
+    Value& Value::operator=(const std::vector<bool>& other)
+    {
+        return *this = Value(other);
+    }
+
+    Value& Value::operator=(const std::vector<std::string>& other)
+    {
+        return *this = Value(other);
+    }
+
+    Value::Array<int> Value::getIntArray() const
+    {
+        return (_type == DataType::INT_ARRAY) ? as<Array<int> >() : Array<int>();
+    }
+
+    Value::Array<double> Value::getNumberArray() const
+    {
+        return (_type == DataType::NUMBER_ARRAY) ? as<Array<double> >() : Array<double>();
+    }
+
+    Value::Array<bool> Value::getBooleanArray() const
+    {
+        return (_type == DataType::BOOL_ARRAY) ? as<Array<bool> >() : Array<bool>();
+    }
+
+    Value::Array<const char*> Value::getStringArray() const
+    {
+        return (_type == DataType::STRING_ARRAY) ? as<Array<const char*> >() : Array<const char*>();
+    }
+
+    bool Value::isArray() const
+    {
+        return _type >= DataType::INT_ARRAY && _type <= DataType::STRING_ARRAY;
+    }
+
+    Value::DataType Value::arrayType(DataType elementType)
+    {
+        switch (elementType) {
+            case DataType::INT: return DataType::INT_ARRAY;
+            case DataType::NUMBER: return DataType::NUMBER_ARRAY;
+            case DataType::BOOL: return DataType::BOOL_ARRAY;
+            case DataType::STRING: return DataType::STRING_ARRAY;
+            default: return DataType::UNKNOWN;
+        }
+    }
+
+    Value::DataType Value::elementType(DataType arrayType)
+    {
+        switch (arrayType) {
+            case DataType::INT_ARRAY: return DataType::INT;
+            case DataType::NUMBER_ARRAY: return DataType::NUMBER;
+            case DataType::BOOL_ARRAY: return DataType::BOOL;
+            case DataType::STRING_ARRAY: return DataType::STRING;
+            default: return DataType::UNKNOWN;
+        }
     }
 
     // print function
-    std::string Value::print()
+    std::string Value::print() const
     {
         const int slen = 31;
         char tempStr[slen + 1];
@@ -167,6 +424,10 @@ namespace miniconf {
                 snprintf(tempStr, slen, "%d", getInt());
                 outStr = std::string(tempStr);
                 break;
+            case DataType::INT64:
+                snprintf(tempStr, slen, "%lld", static_cast<long long>(getInt64()));
+                outStr = std::string(tempStr);
+                break;
             case DataType::NUMBER:
                 snprintf(tempStr, slen, "%f", getNumber());
                 outStr = std::string(tempStr);
@@ -176,7 +437,35 @@ namespace miniconf {
                 outStr = std::string(tempStr);
                 break;
             case DataType::STRING:
-                outStr = "\"" + std::string(getCharArray()) + "\"";
+                outStr = "\"" + getString() + "\"";
+                break;
+            case DataType::INT_ARRAY:
+            case DataType::NUMBER_ARRAY:
+            case DataType::BOOL_ARRAY:
+            case DataType::STRING_ARRAY:
+                outStr = "[";
+                for (size_t i = 0; i < _size; ++i) {
+                    if (i != 0) {
+                        outStr += ", ";
+                    }
+                    switch (_type) {
+                        case DataType::INT_ARRAY:
+                            snprintf(tempStr, slen, "%d", as<Array<int> >()[i]);
+                            outStr += tempStr;
+                            break;
+                        case DataType::NUMBER_ARRAY:
+                            snprintf(tempStr, slen, "%f", as<Array<double> >()[i]);
+                            outStr += tempStr;
+                            break;
+                        case DataType::BOOL_ARRAY:
+                            outStr += as<Array<bool> >()[i] ? "true" : "false";
+                            break;
+                        default:
+                            outStr.append("\"").append(as<Array<const char*> >()[i]).append("\"");
+                            break;
+                    }
+                }
+                outStr += "]";
                 break;
             default:
                 break;
@@ -185,15 +474,21 @@ namespace miniconf {
     }
 
     // return data type
-    Value::DataType Value::type()
+    Value::DataType Value::type() const
     {
         return _type;
     }
 
+    // string length
+    size_t Value::size() const
+    {
+        return _size;
+    }
+
     // check empty
-    bool Value::isEmpty()
+    bool Value::isEmpty() const
     {
-        return (_data == nullptr || _type == DataType::UNKNOWN);
+        return (_type == DataType::UNKNOWN);
     }
 
     // generate unknown value
@@ -202,6 +497,54 @@ namespace miniconf {
         return Value();
     }
 
+    // compare values
+    bool Value::operator==(const Value& other) const
+    {
+        if (_type != other._type) {
+            return false;
+        }
+        switch (_type) {
+            case DataType::INT:
+                return _int == other._int;
+            case DataType::INT64:
+                return _int64 == other._int64;
+            case DataType::NUMBER:
+                return memcmp(&_number, &other._number, sizeof(_number)) == 0;
+            case DataType::BOOL:
+                return _bool == other._bool;
+            case DataType::STRING:
+                return _size == other._size && memcmp(getCharArray(), other.getCharArray(), _size) == 0;
+            case DataType::STRING_ARRAY: {
+                if (_size != other._size) {
+                    return false;
+                }
+                Array<const char*> a = as<Array<const char*> >();
+                Array<const char*> b = other.as<Array<const char*> >();
+                for (size_t i = 0; i < _size; ++i) {
+                    if (strcmp(a[i], b[i]) != 0) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case DataType::INT_ARRAY:
+            case DataType::NUMBER_ARRAY:
+            case DataType::BOOL_ARRAY: {
+                uint64_t bytes, otherBytes;
+                memcpy(&bytes, _heap, sizeof(bytes));
+                memcpy(&otherBytes, other._heap, sizeof(otherBytes));
+                return bytes == otherBytes && memcmp(arrayData(), other.arrayData(), static_cast<size_t>(bytes)) == 0;
+            }
+            default:
+                return true;
+        }
+    }
+
+    bool Value::operator!=(const Value& other) const
+    {
+        return !(*this == other);
+    }
+
     // print value data type
     std::string Value::printType()
     {
@@ -215,6 +558,9 @@ namespace miniconf {
             case DataType::INT:
                 snprintf(tempStr, slen, "INT");
                 break;
+            case DataType::INT64:
+                snprintf(tempStr, slen, "INT64");
+                break;
             case DataType::NUMBER:
                 snprintf(tempStr, slen, "NUMBER");
                 break;
@@ -224,41 +570,103 @@ namespace miniconf {
             case DataType::STRING:
                 snprintf(tempStr, slen, "STRING");
                 break;
+            case DataType::INT_ARRAY:
+                snprintf(tempStr, slen, "INT[]");
+                break;
+            case DataType::NUMBER_ARRAY:
+                snprintf(tempStr, slen, "NUMBER[]");
+                break;
+            case DataType::BOOL_ARRAY:
+                snprintf(tempStr, slen, "BOOLEAN[]");
+                break;
+            case DataType::STRING_ARRAY:
+                snprintf(tempStr, slen, "STRING[]");
+                break;
             default:
                 break;
         }
         return std::string(tempStr);
     }
 
-    // move and copy function
-    Value& Value::moveData(char*& src, const size_t size, const DataType type)
+    // internal use, the storage is bitwise relocatable so moving never allocates
+    Value& Value::moveData(Value& other)
     {
-        _type = type;
+        memcpy(static_cast<void*>(this), static_cast<const void*>(&other), sizeof(Value));
+        other._type = DataType::UNKNOWN;
+        other._size = 0;
+        return *this;
+    }
+
+    // internal use
+    Value& Value::copyString(const char* src, const size_t size)
+    {
+        char* dest = _inline;
+        if (size > INLINE_CAPACITY) {
+            _heap = new char[size + 1];
+            dest = _heap;
+        }
+        memcpy(dest, src, size);
+        dest[size] = '\0';
         _size = size;
-        _data = src;
-        src = nullptr;
+        _type = DataType::STRING;
+        return *this;
+    }
+
+    // internal use, an array buffer starts with its size in bytes, so the elements are 8-byte aligned
+    static const size_t ARRAY_HEADER = sizeof(uint64_t);
+
+    char* Value::allocateArray(DataType type, size_t count, size_t bytes)
+    {
+        _heap = new char[ARRAY_HEADER + bytes];
+        uint64_t size = bytes;
+        memcpy(_heap, &size, sizeof(size));
+        _type = type;
+        _size = count;
+        return _heap + ARRAY_HEADER;
+    }
+
+    // internal use
+    Value& Value::copyArray(const Value& other)
+    {
+        uint64_t bytes;
+        memcpy(&bytes, other._heap, sizeof(bytes));
+        char* data = allocateArray(other._type, other._size, static_cast<size_t>(bytes));
+        memcpy(data, other.arrayData(), static_cast<size_t>(bytes));
+        // the element pointers of a string array are moved to the new buffer
+        if (_type == DataType::STRING_ARRAY) {
+            const char** pointers = reinterpret_cast<const char**>(data);
+            for (size_t i = 0; i < _size; ++i) {
+                pointers[i] = data + (pointers[i] - other.arrayData());
+            }
+        }
         return *this;
     }
 
     // internal use
-    Value& Value::copyData(const char* src, const size_t size, const DataType& type)
+    const char* Value::arrayData() const
     {
-        char* newData = new char[size];
-        memcpy(newData, src, size);
-        return moveData(newData, size, type);
+        return _heap + ARRAY_HEADER;
     }
 
     // internal use
     void Value::clearData()
     {
-        if (_size != 0 && _data != nullptr) {
-            delete _data;
-            _data = nullptr;
+        if (isHeap()) {
+            delete[] _heap;
         }
+        _type = DataType::UNKNOWN;
+        _size = 0;
+    }
+
+    // internal use
+    bool Value::isHeap() const
+    {
+        return (_type == DataType::STRING && _size > INLINE_CAPACITY) || isArray();
     }
 
     // Option
-    Config::Option::Option() : _flag(), _shortflag(), _description(), _defaultValue(Value::unknown()), _required(false), _hidden(false)
+    Config::Option::Option() : _config(nullptr), _slot(0), _flag(), _shortflag(), _description(), _defaultValue(Value::unknown()), _required(false), _hidden(false),
+            _diagnostics(NO_DEFAULT_VALUE | NO_DESCRIPTION | NO_SHORTFLAG)
     {}
 
     Config::Option::~Option()
@@ -266,61 +674,118 @@ namespace miniconf {
 
     Config::Option& Config::Option::flag(const std::string& flag)
     {
+        if (attached()) {
+            if (flag != this->flag()) {
+                _config->log(LogLevel::WARNING, flag, "the flag of a defined option cannot be changed");
+            }
+            return *this;
+        }
         _flag = flag;
         return *this;
     }
 
     Config::Option& Config::Option::shortflag(const std::string& shortflag)
     {
+        bool indexed = attached();
+        if (indexed) {
+            _config->unindexShortflag(_slot);
+        }
         _shortflag = shortflag;
+        if (indexed) {
+            _config->indexShortflag(_slot);
+        }
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::description(const std::string& description)
     {
         _description = description;
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::defaultValue(const Value& defaultValue)
     {
         _defaultValue = defaultValue;
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::defaultValue(const int& defaultValue)
     {
         _defaultValue = static_cast<int>(defaultValue);
+        updateDiagnostics();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const int64_t& defaultValue)
+    {
+        _defaultValue = static_cast<int64_t>(defaultValue);
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::defaultValue(const double& defaultValue)
     {
         _defaultValue = static_cast<double>(defaultValue);
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::defaultValue(const bool& defaultValue)
     {
         _defaultValue = static_cast<bool>(defaultValue);
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::defaultValue(const char* defaultValue)
     {
         _defaultValue = defaultValue;
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::defaultValue(const std::string& defaultValue)
     {
         _defaultValue = static_cast<std::string>(defaultValue);
+        updateDiagnostics();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<int>& defaultValue)
+    {
+        _defaultValue = defaultValue;
+        updateDiagnostics();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<double>& defaultValue)
+    {
+        _defaultValue = defaultValue;
+        updateDiagnostics();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<bool>& defaultValue)
+    {
+        _defaultValue = defaultValue;
+        updateDiagnostics();
+        return *this;
+    }
+
+    Config::Option& Config::Option::defaultValue(const std::vector<std::string>& defaultValue)
+    {
+        _defaultValue = defaultValue;
+        updateDiagnostics();
         return *this;
     }
 
     Config::Option& Config::Option::required(const bool required)
     {
         _required = required;
+        updateDiagnostics();
         return *this;
     }
 
@@ -330,9 +795,42 @@ namespace miniconf {
         return *this;
     }
 
-    std::string Config::Option::flag()
+    Config::Option& Config::Option::onChange(ChangeCallback callback)
     {
-        return _flag;
+        if (attached()) {
+            Subscription subscription = { _config->_nextSubscription++, flag(), true, std::move(callback), BatchCallback() };
+            _config->_subscriptions.push_back(std::move(subscription));
+        }
+        return *this;
+    }
+
+    bool Config::Option::attached() const
+    {
+        // copies of an option are not tracked by the Config object
+        return (_config != nullptr && &(_config->_options[_slot]) == this);
+    }
+
+    void Config::Option::updateDiagnostics()
+    {
+        unsigned char diagnostics = 0;
+        if (!_required && _defaultValue.isEmpty()) {
+            diagnostics |= NO_DEFAULT_VALUE;
+        }
+        if (_description.empty()) {
+            diagnostics |= NO_DESCRIPTION;
+        }
+        if (_shortflag.empty()) {
+            diagnostics |= NO_SHORTFLAG;
+        }
+        if (attached()) {
+            _config->countDiagnostics(_diagnostics, diagnostics);
+        }
+        _diagnostics = diagnostics;
+    }
+
+    const std::string& Config::Option::flag() const
+    {
+        return (_config != nullptr) ? _config->_flags[_slot] : _flag;
     }
 
     std::string Config::Option::shortflag()
@@ -365,726 +863,5439 @@ namespace miniconf {
         return _defaultValue.type();
     }
 
-    Config::Config() :
-            _verbose(false),
-            _logLevel(Config::LogLevel::WARNING),
-            _exeName(""),
-            _description(""),
-            _autoHelp(true),
-            _loadConfig(true)
-    {
-        enableHelp(true); // set auto help to true
-        enableConfig(true); // set auto config to true
-    }
+    static const size_t FLAG_HASH_SEED = static_cast<size_t>(14695981039346656037ULL);
 
-    Config::~Config()
+    /* FNV-1a hash of a flag
+     *
+     * The hash is computed incrementally, hashing "b" with the hash of "a" as the seed gives the
+     * hash of "ab", so a dotted flag can be hashed segment by segment.
+     */
+    static size_t hashFlag(const char* flag, size_t length, size_t seed = FLAG_HASH_SEED)
     {
-        _options.clear();
-        _optionValues.clear();
-        _log.clear();
+        size_t hash = seed;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(flag[i]);
+            hash *= static_cast<size_t>(1099511628211ULL);
+        }
+        return hash;
     }
 
-    Config::Option& Config::option(const std::string& flag)
-    {
-        _options.insert(std::make_pair(flag, Config::Option().flag(flag)));
-        return _options[flag];
-    }
+    // ConfigSnapshot
 
-    bool Config::remove(const std::string& flag)
+    /* Reader state of one thread for one Config object
+     *
+     * A reader announces the epoch in which it pinned a snapshot, or 0 when it holds no guard.
+     * A snapshot retired in epoch e is released once every announced epoch is greater than e.
+     * The record is padded so the epochs of different threads are not on the same cache line.
+     */
+    struct ConfigSnapshot::Reader
     {
-        if (findOption(flag)){
-            _options.erase(flag);
-            return true;
-        }
-        return false;
-    }
+        Reader() : epoch(0), depth(0), inUse(true), next(nullptr) {}
 
-    void Config::setDefaultValues()
-    {
-        for (auto && o : _options) {
-            _optionValues[o.first] = o.second.defaultValue();
-        }
-    }
+        std::atomic<unsigned long long> epoch;
+        unsigned depth;             // number of guards, only accessed by the owning thread
+        std::atomic<bool> inUse;    // whether a thread owns the record
+        Reader* next;               // next registered record, never changes once registered
+        char padding[64];
+    };
 
-    void Config::log(const LogLevel logType)
+    /* Published snapshots of a Config object
+     *
+     * The domain is shared by the Config object and the threads which have read from it, 
+     * so the reader records stay valid until the last of these threads exits.
+     */
+    class Config::SnapshotDomain
     {
-        _logLevel = logType;
-    }
+        public:
 
-    void Config::log(FILE* fd)
-    {
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "PARSE LOG");
-        for (auto && logline : _log) {
-            fprintf(fd, "%s\n", logline.c_str());
-        }
-    }
+            SnapshotDomain() : _current(nullptr), _epoch(1), _readers(nullptr), _closed(false), _version(0) {}
 
-    void Config::log(Config::LogLevel logType, const std::string& token, const std::string& msg)
-    {
-        // do don't anything if log level is low
-        if (logType < _logLevel) {
-            return;
-        }
-        const int tagWidth = 16;
-        char tag[tagWidth + 1];
-        char format[tagWidth + 1];
-        std::string logString = "";
-        snprintf(format, tagWidth, "<<<%%%ds>>>", tagWidth - 7);
-        switch (logType) {
-            case Config::LogLevel::INFO:
-                snprintf(tag, tagWidth, format, "INFO");
-                break;
-            case Config::LogLevel::WARNING:
-                snprintf(tag, tagWidth, format, "WARNING");
-                break;
-            case Config::LogLevel::ERROR:
-                snprintf(tag, tagWidth, format, "ERROR");
-                break;
-            default:
-                break;
+            ~SnapshotDomain()
+            {
+                close();
+                ConfigSnapshot::Reader* reader = _readers.load();
+                while (reader != nullptr) {
+                    ConfigSnapshot::Reader* next = reader->next;
+                    delete reader;
+                    reader = next;
+                }
+            }
+
+            // replaces the current snapshot, and releases retired snapshots which are not read anymore
+            void publish(ConfigSnapshot* snapshot)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                snapshot->_version = ++_version;
+                ConfigSnapshot* previous = _current.exchange(snapshot);
+                if (previous != nullptr) {
+                    _retired.push_back(std::make_pair(previous, _epoch.fetch_add(1)));
+                }
+                reclaim();
+            }
+
+            // releases all snapshots, no guard may exist anymore
+            void close()
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                delete _current.exchange(nullptr);
+                for (size_t i = 0; i < _retired.size(); ++i) {
+                    delete _retired[i].first;
+                }
+                _retired.clear();
+                _closed.store(true);
+            }
+
+            // gets the reader record of the calling thread, it is registered on the first call
+            static ConfigSnapshot::Reader* threadReader(const std::shared_ptr<SnapshotDomain>& domain)
+            {
+                static thread_local ThreadReaders readers;
+                for (size_t i = 0; i < readers.entries.size(); ++i) {
+                    if (readers.entries[i].first.get() == domain.get()) {
+                        return readers.entries[i].second;
+                    }
+                }
+                readers.prune();
+                ConfigSnapshot::Reader* reader = domain->claimReader();
+                readers.entries.push_back(std::make_pair(domain, reader));
+                return reader;
+            }
+
+            std::atomic<ConfigSnapshot*> _current;
+
+            // incremented by every publish(), announced by readers
+            std::atomic<unsigned long long> _epoch;
+
+        private:
+
+            // reader records owned by one thread, given back when the thread exits
+            struct ThreadReaders
+            {
+                ~ThreadReaders()
+                {
+                    for (size_t i = 0; i < entries.size(); ++i) {
+                        entries[i].second->inUse.store(false);
+                    }
+                }
+
+                // drops the records of Config objects which have been destroyed
+                void prune()
+                {
+                    size_t kept = 0;
+                    for (size_t i = 0; i < entries.size(); ++i) {
+                        if (entries[i].first->_closed.load()) {
+                            entries[i].second->inUse.store(false);
+                        } else {
+                            entries[kept++] = entries[i];
+                        }
+                    }
+                    entries.resize(kept);
+                }
+
+                std::vector<std::pair<std::shared_ptr<SnapshotDomain>, ConfigSnapshot::Reader*> > entries;
+            };
+
+            // reuses a record given back by an exited thread, or registers a new one
+            ConfigSnapshot::Reader* claimReader()
+            {
+                for (ConfigSnapshot::Reader* reader = _readers.load(); reader != nullptr; reader = reader->next) {
+                    bool inUse = false;
+                    if (reader->inUse.compare_exchange_strong(inUse, true)) {
+                        return reader;
+                    }
+                }
+                ConfigSnapshot::Reader* reader = new ConfigSnapshot::Reader();
+                reader->next = _readers.load();
+                while (!_readers.compare_exchange_weak(reader->next, reader)) {
+                }
+                return reader;
+            }
+
+            // releases the retired snapshots older than the oldest epoch announced by a reader
+            void reclaim()
+            {
+                unsigned long long oldest = std::numeric_limits<unsigned long long>::max();
+                for (ConfigSnapshot::Reader* reader = _readers.load(); reader != nullptr; reader = reader->next) {
+                    unsigned long long epoch = reader->epoch.load();
+                    if (epoch != 0 && epoch < oldest) {
+                        oldest = epoch;
+                    }
+                }
+                size_t kept = 0;
+                for (size_t i = 0; i < _retired.size(); ++i) {
+                    if (_retired[i].second < oldest) {
+                        delete _retired[i].first;
+                    } else {
+                        _retired[kept++] = _retired[i];
+                    }
+                }
+                _retired.resize(kept);
+            }
+
+            // lock-free list of reader records
+            std::atomic<ConfigSnapshot::Reader*> _readers;
+
+            // set when the Config object is destroyed
+            std::atomic<bool> _closed;
+
+            // serializes publish() and close(), readers never take it
+            std::mutex _mutex;
+
+            // replaced snapshots and the epoch in which they were replaced
+            std::vector<std::pair<ConfigSnapshot*, unsigned long long> > _retired;
+
+            unsigned long long _version;
+    };
+
+    ConfigSnapshot::ConfigSnapshot() : _version(0)
+    {}
+
+    const Value* ConfigSnapshot::find(const std::string& flag) const
+    {
+        if (_index.empty()) {
+            return nullptr;
         }
-        logString = std::string(tag) + " Input \"" + token + "\" : " + msg;
-        _log.emplace_back(logString);
-        if (_verbose) {
-            fprintf(stdout, "%s\n", logString.c_str());
+        size_t mask = _index.size() - 1;
+        size_t hash = hashFlag(flag.data(), flag.size());
+        size_t bucket = hash & mask;
+        while (_index[bucket] != 0) {
+            size_t i = _index[bucket] - 1;
+            if (_hashes[i] == hash && *_flags[i] == flag) {
+                return &_values[i];
+            }
+            bucket = (bucket + 1) & mask;
         }
+        return nullptr;
     }
 
-    Config::TokenType Config::getTokenType(const char* token)
+    bool ConfigSnapshot::contains(const std::string& flag) const
     {
-        // get token type:
-        // starts with "--" - flag
-        // starts with "-" - shortflag/value
-        // otherwise value
-        size_t tlen = strlen(token);
-        if (tlen == 0) return TokenType::UNKNOWN;
-        if (token[0] == '-') {
-            // check if it can be converted to a number
-            char* endptr = nullptr;
-            std::strtod(token, &endptr);
-            if (*endptr == '\0' && endptr != token) {
-                return TokenType::VALUE;
-            }
-            return (token[1] == '-') ? TokenType::FLAG : TokenType::SHORTFLAG;
-        }
-        return TokenType::VALUE;
+        return find(flag) != nullptr;
     }
 
-    std::string Config::translateShortflag(const std::string& shortflag)
+    const Value& ConfigSnapshot::operator[](const std::string& flag) const
     {
-        auto found = _options.begin();
-        auto end = _options.end();
-        for (; found != end; ++found) {
-            if (found->second.shortflag() == shortflag) {
-                break;
-            }
-        }
-        if (found != end) {
-            return found->first;
+        const Value* value = find(flag);
+        if (value == nullptr) {
+            throw std::out_of_range("miniconf::ConfigSnapshot: undefined option value " + flag);
         }
-        return shortflag;
+        return *value;
     }
 
-    bool Config::findOption(const std::string& flag)
+    size_t ConfigSnapshot::size() const
     {
-        return (_options.find(flag) != _options.end());
+        return _values.size();
     }
 
-    Config::Option* Config::getOption(const char* token, Config::TokenType tokenType)
+    unsigned long long ConfigSnapshot::version() const
     {
-        std::string flag = "";
-        if (tokenType == TokenType::FLAG) {
-            flag = std::string(token + 2);
-        } else if (tokenType == TokenType::SHORTFLAG) {
-            flag = translateShortflag(std::string(token + 1));
+        return _version;
+    }
+
+    ConfigSnapshot::Guard::Guard(Reader* reader, const ConfigSnapshot* snapshot) : _reader(reader), _snapshot(snapshot)
+    {}
+
+    ConfigSnapshot::Guard::Guard(Guard&& other) : _reader(other._reader), _snapshot(other._snapshot)
+    {
+        other._reader = nullptr;
+    }
+
+    ConfigSnapshot::Guard::~Guard()
+    {
+        if (_reader != nullptr && --_reader->depth == 0) {
+            _reader->epoch.store(0, std::memory_order_release);
         }
-        if (flag.empty()) {
-            return nullptr;
+    }
+
+    void Config::publish()
+    {
+        loadMappedEntries();
+        ConfigSnapshot* snapshot = new ConfigSnapshot();
+        for (size_t slot : sortedSlots()) {
+            if (hasValue(slot)) {
+                snapshot->_flags.push_back(&_flags[slot]);
+                snapshot->_hashes.push_back(_flagHashes[slot]);
+                snapshot->_values.push_back(_optionValues[slot]);
+            }
         }
-        if (findOption(flag)) {
-            return &(_options[flag]);
+        size_t buckets = 16;
+        while (buckets < snapshot->_flags.size() * 2) {
+            buckets *= 2;
         }
-        return nullptr;
+        snapshot->_index.assign(buckets, 0);
+        for (size_t i = 0; i < snapshot->_flags.size(); ++i) {
+            size_t bucket = snapshot->_hashes[i] & (buckets - 1);
+            while (snapshot->_index[bucket] != 0) {
+                bucket = (bucket + 1) & (buckets - 1);
+            }
+            snapshot->_index[bucket] = i + 1;
+        }
+        _snapshots->publish(snapshot);
     }
 
-    Value Config::parseValue(const char* token, Value::DataType dataType)
+    ConfigSnapshot::Guard Config::acquire() const
     {
-        if (dataType == Value::DataType::INT) {
-            int v;
-            int success = sscanf(token, "%d", &v);
-            return (success == 1) ? Value(v) : Value::unknown();
+        static const ConfigSnapshot empty;
+        ConfigSnapshot::Reader* reader = SnapshotDomain::threadReader(_snapshots);
+        // the epoch is announced before the snapshot is loaded, so a publish() which
+        // replaces the snapshot afterwards sees the announcement and keeps it alive
+        if (reader->depth++ == 0) {
+            reader->epoch.store(_snapshots->_epoch.load());
         }
-        if (dataType == Value::DataType::NUMBER) {
-            double v;
-            int success = sscanf(token, "%lf", &v);
-            return (success == 1) ? Value(v) : Value();
+        const ConfigSnapshot* snapshot = _snapshots->_current.load();
+        return ConfigSnapshot::Guard(reader, snapshot != nullptr ? snapshot : &empty);
+    }
 
-        }
-        if (dataType == Value::DataType::BOOL) {
-            std::string v(token);
-            if (v == "false" || v == "False" || v == "FALSE" || v == "F" || v == "f") {
-                return Value(false);
-            }
-            return Value(true);
+    Config::Config() :
+            _shortflagCount(0),
+            _duplicateShortflags(0),
+            _formatErrors(0),
+            _formatWarnings(0),
+            _loading(nullptr),
+#ifdef MINICONF_JSON_SUPPORT
+            _jsonParser(JSONParser::PICOJSON),
+#endif
+            _recording(false),
+            _batchDepth(0),
+            _nextSubscription(1),
+            _verbose(false),
+            _logLevel(Config::LogLevel::WARNING),
+            _exeName(""),
+            _description(""),
+            _autoHelp(true),
+            _loadConfig(true),
+            _snapshots(std::make_shared<SnapshotDomain>())
+    {
+        PathNode root = { "", 0, 0, NO_SLOT, FLAG_HASH_SEED, NO_SLOT, NO_SLOT, NO_SLOT, NO_SLOT, NO_SLOT, false };
+        _nodes.push_back(root);
+        enableHelp(true); // set auto help to true
+        enableConfig(true); // set auto config to true
+    }
+
+    Config::~Config()
+    {
+        _snapshots->close();
+        _options.clear();
+        _optionValues.clear();
+        _log.clear();
+    }
 
+    const size_t Config::NO_SLOT;
+
+    size_t Config::findSlot(const char* flag, size_t length, size_t hash) const
+    {
+        if (_slotIndex.empty()) {
+            return NO_SLOT;
         }
-        if (dataType == Value::DataType::STRING) {
-            return Value(token);
+        size_t mask = _slotIndex.size() - 1;
+        for (size_t bucket = hash & mask; _slotIndex[bucket] != 0; bucket = (bucket + 1) & mask) {
+            size_t slot = _slotIndex[bucket] - 1;
+            if (_flagHashes[slot] == hash && _flags[slot].size() == length &&
+                    memcmp(_flags[slot].data(), flag, length) == 0) {
+                return slot;
+            }
         }
-        return Value::unknown(); // fool-proof, return an unknown
+        return NO_SLOT;
     }
 
-    static Config::LogLevel worseLevel(const Config::LogLevel& a, const Config::LogLevel& b)
+    size_t Config::findSlot(const char* flag, size_t length) const
     {
-        return ((a) < (b)) ? (b) : (a);
+        return findSlot(flag, length, hashFlag(flag, length));
     }
 
-    Config::LogLevel Config::checkFormat()
+    size_t Config::findSlot(const std::string& flag) const
     {
-        LogLevel errorLv = LogLevel::INFO;
-        for (auto && opt : _options) {
-            Option& o = opt.second;
-            // check for error
-            if (!o.required() && o.defaultValue().isEmpty()) {
-                log(LogLevel::ERROR, o.flag(), "default value is not defined");
-                errorLv = worseLevel(errorLv, LogLevel::ERROR);
-            }
-            for (auto& opt2 : _options) {
-                Option& o2 = opt2.second;
-                if ((o.flag() != o2.flag()) && (o.shortflag() == o2.shortflag()) && !(o.shortflag().empty())) {
-                    log(LogLevel::ERROR, o.flag(), "duplicate short flags (" + o2.shortflag() + ")");
-                    errorLv = worseLevel(errorLv, LogLevel::ERROR);
+        return findSlot(flag.data(), flag.size());
+    }
+
+    size_t Config::acquireSlot(const std::string& flag)
+    {
+        return acquireSlot(flag.data(), flag.size());
+    }
+
+    size_t Config::acquireSlot(const char* flag, size_t length)
+    {
+        return acquireSlot(flag, length, hashFlag(flag, length));
+    }
+
+    size_t Config::acquireSlot(const char* flag, size_t length, size_t hash)
+    {
+        size_t slot = findSlot(flag, length, hash);
+        if (slot != NO_SLOT) {
+            return slot;
+        }
+
+        // keep the load factor of the hash index below 1/2
+        if ((_flags.size() + 1) * 2 > _slotIndex.size()) {
+            std::vector<size_t> newIndex(_slotIndex.empty() ? 16 : _slotIndex.size() * 2, 0);
+            size_t mask = newIndex.size() - 1;
+            for (size_t i = 0; i < _flags.size(); ++i) {
+                size_t bucket = _flagHashes[i] & mask;
+                while (newIndex[bucket] != 0) {
+                    bucket = (bucket + 1) & mask;
                 }
+                newIndex[bucket] = i + 1;
             }
-            // check for warnings
-            if (o.description().empty()) {
-                log(LogLevel::WARNING, o.flag(), "no description text for argument");
-                errorLv = worseLevel(errorLv, LogLevel::WARNING);
-            }
-            if (o.shortflag().empty()) {
-                log(LogLevel::WARNING, o.flag(), "no short flag is provided");
-                errorLv = worseLevel(errorLv, LogLevel::WARNING);
-            }
+            _slotIndex.swap(newIndex);
         }
-        if (_description.empty()) {
-            log(LogLevel::WARNING, "", "No program description text is provided");
-            errorLv = worseLevel(errorLv, LogLevel::WARNING);
+
+        slot = _flags.size();
+        _flags.emplace_back(flag, length);
+        _flagHashes.push_back(hash);
+        _slotStates.push_back(0);
+        _options.emplace_back();
+        _optionValues.emplace_back();
+        _slotLayers.push_back(NO_SLOT);
+        _shortflagNext.push_back(NO_SLOT);
+
+        size_t mask = _slotIndex.size() - 1;
+        size_t bucket = hash & mask;
+        while (_slotIndex[bucket] != 0) {
+            bucket = (bucket + 1) & mask;
         }
-        return errorLv;
+        _slotIndex[bucket] = slot + 1;
+        indexPath(slot);
+        if (!_mappedSnapshots.empty()) {
+            loadMappedSlot(slot);
+        }
+        return slot;
     }
 
-    // Validate User Input
-    Config::LogLevel Config::validate()
+    size_t Config::findNode(const char* path, size_t length, size_t hash) const
     {
-        LogLevel errorLv = LogLevel::INFO;
-
-        // remove all the hidden values
-        for (auto&& opt: _options){
-            if (opt.second.hidden() && contains(opt.first)){
-                _optionValues.erase(opt.first);
+        if (length == 0) {
+            return 0;
+        }
+        if (_nodeIndex.empty()) {
+            return NO_SLOT;
+        }
+        size_t mask = _nodeIndex.size() - 1;
+        for (size_t bucket = hash & mask; _nodeIndex[bucket] != 0; bucket = (bucket + 1) & mask) {
+            const PathNode& node = _nodes[_nodeIndex[bucket]];
+            if (node.hash == hash && node.length == length && memcmp(node.path, path, length) == 0) {
+                return _nodeIndex[bucket];
             }
         }
+        return NO_SLOT;
+    }
 
-        // scan for all option vlaues
-        for (auto && val : _optionValues) {
-            if (val.second.isEmpty()) {
-                log(LogLevel::ERROR, val.first, "option contains invalid value");
-                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+    size_t Config::findNode(const std::string& path) const
+    {
+        return findNode(path.data(), path.size(), hashFlag(path.data(), path.size()));
+    }
+
+    size_t Config::findChild(size_t node, const char* segment, size_t length) const
+    {
+        if (_nodeIndex.empty() || length == 0) {
+            return NO_SLOT;
+        }
+        // a segment which is not interned is not part of any flag
+        size_t segmentHash = hashFlag(segment, length);
+        size_t name = findSegment(segment, length, segmentHash);
+        if (name == NO_SLOT) {
+            return NO_SLOT;
+        }
+        // the hash of the child continues the hash of its parent
+        size_t hash = (node == 0) ? segmentHash : hashFlag(segment, length, hashFlag(".", 1, _nodes[node].hash));
+        size_t mask = _nodeIndex.size() - 1;
+        for (size_t bucket = hash & mask; _nodeIndex[bucket] != 0; bucket = (bucket + 1) & mask) {
+            const PathNode& child = _nodes[_nodeIndex[bucket]];
+            if (child.name == name && child.parent == node) {
+                return _nodeIndex[bucket];
             }
         }
+        return NO_SLOT;
+    }
 
-        // scan for all remaining options are defined
-        for (auto && opt : _options) {
-            if (!contains(opt.first) && !opt.second.hidden()) {
-                log(LogLevel::ERROR, opt.first, "option is undefined");
-                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+    size_t Config::findSegment(const char* segment, size_t length, size_t hash) const
+    {
+        if (_segmentIndex.empty()) {
+            return NO_SLOT;
+        }
+        size_t mask = _segmentIndex.size() - 1;
+        for (size_t bucket = hash & mask; _segmentIndex[bucket] != 0; bucket = (bucket + 1) & mask) {
+            size_t name = _segmentIndex[bucket] - 1;
+            if (_segmentHashes[name] == hash && _segments[name].size() == length &&
+                    memcmp(_segments[name].data(), segment, length) == 0) {
+                return name;
             }
         }
-        return errorLv;
+        return NO_SLOT;
     }
 
-    bool Config::parse(int argc, char **argv)
+    size_t Config::internSegment(const char* segment, size_t length)
     {
-        // Extract executable name
-        _exeName = std::string(argv[0]);
-        size_t lastslash = _exeName.find_last_of("\\/");
-        if (lastslash != std::string::npos) {
-            _exeName = _exeName.substr(lastslash + 1);
+        size_t hash = hashFlag(segment, length);
+        size_t name = findSegment(segment, length, hash);
+        if (name != NO_SLOT) {
+            return name;
         }
 
-        // check format of the option parser
-        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
-        LogLevel checkFormatResult = checkFormat();
-        if (checkFormatResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
-            log();
-            printf("\nFatal Error: Option format validation failed, abort.\n\n");
-            return false;
+        // keep the load factor of the hash index below 1/2
+        if ((_segments.size() + 1) * 2 > _segmentIndex.size()) {
+            std::vector<size_t> newIndex(_segmentIndex.empty() ? 16 : _segmentIndex.size() * 2, 0);
+            size_t mask = newIndex.size() - 1;
+            for (size_t i = 0; i < _segments.size(); ++i) {
+                size_t bucket = _segmentHashes[i] & mask;
+                while (newIndex[bucket] != 0) {
+                    bucket = (bucket + 1) & mask;
+                }
+                newIndex[bucket] = i + 1;
+            }
+            _segmentIndex.swap(newIndex);
         }
 
-        // define a wildcard option to capture "stray" option values (values without a flag)
-        // string argument by default
-        Config::Option wildcard;
-        wildcard.defaultValue("");
-
-        // Value Precedence:
-        // (1) Default Value
-        // (2) Config File Settings (overwrites default values)
-        // (3) Command Line Arguments (overwrites default values and config file)
-
-        // * Set Default Values
-        setDefaultValues();
+        name = _segments.size();
+        _segments.emplace_back(segment, length);
+        _segmentHashes.push_back(hash);
+        size_t mask = _segmentIndex.size() - 1;
+        size_t bucket = hash & mask;
+        while (_segmentIndex[bucket] != 0) {
+            bucket = (bucket + 1) & mask;
+        }
+        _segmentIndex[bucket] = name + 1;
+        return name;
+    }
 
-        // * Load Config File before scanning for other arguments
-        // case 1: only config file is defined, flag is not necessary
-        // case 2: check if config flag has been defined
-        if (_loadConfig) {
-            for (int i = 1; i < argc - 1; ++i) {
-                std::string flag = std::string(argv[i]);
-                std::string value = std::string(argv[i + 1]);
-                TokenType ttype = getTokenType(argv[i + 1]);
-                if (( flag == "--config" || flag == "-cfg" ) && (ttype == TokenType::VALUE)) {
-                    config(value);
-                }
-            }
+    // compares the last segments of two path nodes like std::string::compare
+    static int compareSegments(const char* a, size_t aLength, const char* b, size_t bLength)
+    {
+        int result = memcmp(a, b, std::min(aLength, bLength));
+        if (result != 0) {
+            return result;
         }
+        return (aLength < bLength) ? -1 : (aLength > bLength ? 1 : 0);
+    }
 
-        // start normal parsing
-        Option* currentOption = nullptr;
-        for (int i = 1; i < argc; ++i) {
-            TokenType currentTokenType = getTokenType(argv[i]);
-            if (currentTokenType == TokenType::UNKNOWN) {
-                log(LogLevel::ERROR, std::string(argv[i]), "unknown input");
-            } else if (currentTokenType == TokenType::FLAG || currentTokenType == TokenType::SHORTFLAG) {
-                currentOption = getOption(argv[i], currentTokenType);
-                if (!currentOption) {
-                    log(LogLevel::WARNING, std::string(argv[i]), "unrecognized flag");
-                    if (currentTokenType == TokenType::FLAG) {
-                        wildcard.flag(std::string(argv[i] + 2));
-                        currentOption = &wildcard;
+    void Config::indexPath(size_t slot)
+    {
+        const std::string& flag = _flags[slot];
+        size_t node = 0;
+        size_t hash = FLAG_HASH_SEED;
+        size_t begin = 0;
+        if (!flag.empty()) {
+            while (true) {
+                size_t dot = flag.find('.', begin);
+                size_t end = (dot == std::string::npos) ? flag.size() : dot;
+                hash = hashFlag(flag.data() + begin, end - begin, hash);
+                size_t child = findNode(flag.data(), end, hash);
+                if (child == NO_SLOT) {
+                    size_t name = internSegment(flag.data() + begin, end - begin);
+                    child = _nodes.size();
+                    PathNode created = { flag.data(), end, begin, name, hash, node, NO_SLOT, NO_SLOT, NO_SLOT, NO_SLOT, false };
+                    _nodes.push_back(created);
+
+                    // link the child in the order of the segments, flags are usually added in order,
+                    // children added out of order are sorted before the next walk
+                    const char* segment = flag.data() + begin;
+                    size_t length = end - begin;
+                    PathNode& parent = _nodes[node];
+                    if (parent.firstChild == NO_SLOT) {
+                        parent.firstChild = parent.lastChild = child;
+                    } else {
+                        const std::string& last = _segments[_nodes[parent.lastChild].name];
+                        if (!parent.unsorted && compareSegments(last.data(), last.size(), segment, length) > 0) {
+                            parent.unsorted = true;
+                            _unsortedNodes.push_back(node);
+                        }
+                        _nodes[parent.lastChild].nextSibling = child;
+                        parent.lastChild = child;
                     }
-                }
-                // special case - if the option type is bool, set to true by default
-                if (currentOption && currentOption->type() == Value::DataType::BOOL) {
-                    _optionValues[currentOption->flag()] = true;
-                }
-            } else if (currentTokenType == TokenType::VALUE) {
-                if (currentOption) {
-                    // parse the value according to default data type
-                    Value newValue = parseValue(argv[i], currentOption->type());
-                    // if value cannot be parsed
-                    if (newValue.isEmpty()) {
-                        log(LogLevel::WARNING, std::string(argv[i]), "unvalid value type is provided");
+
+                    // keep the load factor of the hash index below 1/2
+                    if (_nodes.size() * 2 > _nodeIndex.size()) {
+                        std::vector<size_t> newIndex(_nodeIndex.empty() ? 16 : _nodeIndex.size() * 2, 0);
+                        size_t mask = newIndex.size() - 1;
+                        for (size_t i = 1; i < _nodes.size(); ++i) {
+                            size_t bucket = _nodes[i].hash & mask;
+                            while (newIndex[bucket] != 0) {
+                                bucket = (bucket + 1) & mask;
+                            }
+                            newIndex[bucket] = i;
+                        }
+                        _nodeIndex.swap(newIndex);
                     } else {
-                        // assign parsed values
-                        _optionValues[currentOption->flag()] = parseValue(argv[i], currentOption->type());
-                        log(LogLevel::INFO, std::string(argv[i]), "value parsed successfully");
+                        size_t mask = _nodeIndex.size() - 1;
+                        size_t bucket = hash & mask;
+                        while (_nodeIndex[bucket] != 0) {
+                            bucket = (bucket + 1) & mask;
+                        }
+                        _nodeIndex[bucket] = child;
                     }
-                    // reset current option flag -> ready for a new flag
-                    currentOption = nullptr;
-                } else {
-                    // stray arguments, ignore
-                    log(LogLevel::WARNING, std::string(argv[i]), "unassociated argument is not stored");
                 }
+                node = child;
+                if (dot == std::string::npos) {
+                    break;
+                }
+                hash = hashFlag(".", 1, hash);
+                begin = dot + 1;
             }
         }
+        _nodes[node].slot = slot;
+    }
 
-        // if contains help and auto-help is enabled, display help message
-        if (contains("help") && _optionValues["help"].getBoolean() && _autoHelp) {
-            help();
+    void Config::sortNodes()
+    {
+        std::vector<size_t> children;
+        for (size_t node : _unsortedNodes) {
+            children.clear();
+            for (size_t child = _nodes[node].firstChild; child != NO_SLOT; child = _nodes[child].nextSibling) {
+                children.push_back(child);
+            }
+            const std::vector<PathNode>& nodes = _nodes;
+            const std::deque<std::string>& segments = _segments;
+            std::sort(children.begin(), children.end(), [&nodes, &segments](size_t a, size_t b) {
+                return segments[nodes[a].name] < segments[nodes[b].name];
+            });
+            for (size_t i = 0; i + 1 < children.size(); ++i) {
+                _nodes[children[i]].nextSibling = children[i + 1];
+            }
+            _nodes[children.back()].nextSibling = NO_SLOT;
+            _nodes[node].firstChild = children.front();
+            _nodes[node].lastChild = children.back();
+            _nodes[node].unsorted = false;
         }
+        _unsortedNodes.clear();
+    }
 
-        // validate user inputs
-        // remove all hidden options
-        // reserved words should not be displayed as normal config values
-
-        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
-        LogLevel validateResult = validate();
-        if (validateResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
-            log();
-            printf("\nFatal Error: Option format validation failed, abort.\n\n");
-            return false;
+    size_t Config::nextNode(size_t node, size_t root) const
+    {
+        if (_nodes[node].firstChild != NO_SLOT) {
+            return _nodes[node].firstChild;
         }
-
-        return true;
+        while (node != root) {
+            if (_nodes[node].nextSibling != NO_SLOT) {
+                return _nodes[node].nextSibling;
+            }
+            node = _nodes[node].parent;
+        }
+        return NO_SLOT;
     }
 
-    void Config::help(FILE* fd)
+    size_t Config::findSlot(size_t node, const char* key, size_t length) const
     {
-        // print program description
-        if (!_description.empty()) {
+        const PathNode& prefix = _nodes[node];
+        if (node == 0) {
+            return findSlot(key, length);
+        }
+        // the hash of the flag continues the precomputed hash of the prefix
+        size_t hash = hashFlag(key, length, hashFlag(".", 1, prefix.hash));
+        size_t size = prefix.length + 1 + length;
+        if (_slotIndex.empty()) {
+            return NO_SLOT;
+        }
+        size_t mask = _slotIndex.size() - 1;
+        for (size_t bucket = hash & mask; _slotIndex[bucket] != 0; bucket = (bucket + 1) & mask) {
+            size_t slot = _slotIndex[bucket] - 1;
+            const std::string& flag = _flags[slot];
+            if (_flagHashes[slot] == hash && flag.size() == size && flag[prefix.length] == '.' &&
+                    memcmp(flag.data() + prefix.length + 1, key, length) == 0 &&
+                    memcmp(flag.data(), prefix.path, prefix.length) == 0) {
+                return slot;
+            }
+        }
+        return NO_SLOT;
+    }
+
+    Config::View Config::view(const std::string& section)
+    {
+        size_t node = findNode(section);
+        return (node != NO_SLOT) ? View(this, node) : missingView(section);
+    }
+
+    Config::View Config::missingView(const std::string& section)
+    {
+        // no slot is added for the section, the view finds its node once a flag within it is added;
+        // views of missing sections are rare, the sections are searched linearly
+        size_t missing = 0;
+        while (missing < _missingSections.size() && _missingSections[missing] != section) {
+            ++missing;
+        }
+        if (missing == _missingSections.size()) {
+            _missingSections.push_back(section);
+        }
+        return View(this, NO_SLOT, missing);
+    }
+
+    // View
+    size_t Config::View::node() const
+    {
+        if (_node == NO_SLOT && _config != nullptr) {
+            _node = _config->findNode(_config->_missingSections[_missing]);
+        }
+        return _node;
+    }
+
+    std::string Config::View::section() const
+    {
+        if (node() == NO_SLOT) {
+            return (_config != nullptr) ? _config->_missingSections[_missing] : std::string();
+        }
+        const PathNode& node = _config->_nodes[_node];
+        return std::string(node.path, node.length);
+    }
+
+    size_t Config::View::findSlot(const char* key, size_t length) const
+    {
+        if (_config == nullptr || node() == NO_SLOT) {
+            return NO_SLOT;
+        }
+        size_t slot = _config->findSlot(_node, key, length);
+        // the flag may be an entry of an attached snapshot which has not been looked up yet
+        if (slot == NO_SLOT && !_config->_mappedSnapshots.empty()) {
+            std::string flag = section();
+            if (!flag.empty()) {
+                flag.push_back('.');
+            }
+            flag.append(key, length);
+            slot = _config->lookupSlot(flag);
+        }
+        return (slot != NO_SLOT && _config->hasValue(slot)) ? slot : NO_SLOT;
+    }
+
+    const Value* Config::View::find(const char* key) const
+    {
+        size_t slot = findSlot(key, strlen(key));
+        return (slot != NO_SLOT) ? &_config->_optionValues[slot] : nullptr;
+    }
+
+    const Value* Config::View::find(const std::string& key) const
+    {
+        size_t slot = findSlot(key.data(), key.size());
+        return (slot != NO_SLOT) ? &_config->_optionValues[slot] : nullptr;
+    }
+
+    bool Config::View::contains(const char* key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    bool Config::View::contains(const std::string& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    const Value& Config::View::operator[](const char* key) const
+    {
+        const Value* value = find(key);
+        if (value == nullptr) {
+            throw std::out_of_range("miniconf::Config::View: undefined option value " + std::string(key));
+        }
+        return *value;
+    }
+
+    const Value& Config::View::operator[](const std::string& key) const
+    {
+        const Value* value = find(key);
+        if (value == nullptr) {
+            throw std::out_of_range("miniconf::Config::View: undefined option value " + key);
+        }
+        return *value;
+    }
+
+    Config::View Config::View::view(const std::string& section) const
+    {
+        if (_config == nullptr) {
+            return View();
+        }
+        // descend from the node of this view one segment at a time
+        size_t current = node();
+        for (size_t begin = 0; current != NO_SLOT && begin < section.size(); ) {
+            size_t dot = section.find('.', begin);
+            size_t end = (dot == std::string::npos) ? section.size() : dot;
+            current = _config->findChild(current, section.data() + begin, end - begin);
+            begin = end + 1;
+        }
+        if (current != NO_SLOT) {
+            return View(_config, current);
+        }
+        std::string prefix = this->section();
+        return _config->missingView(prefix.empty() ? section : prefix + "." + section);
+    }
+
+    void Config::forEach(const std::string& section, const std::function<void(const std::string& flag, Value& value)>& visitor)
+    {
+        loadMappedEntries();
+        size_t root = findNode(section);
+        sortNodes();
+        for (size_t node = root; node != NO_SLOT; node = nextNode(node, root)) {
+            size_t slot = _nodes[node].slot;
+            if (slot != NO_SLOT && hasValue(slot)) {
+                visitor(_flags[slot], _optionValues[slot]);
+            }
+        }
+    }
+
+    Value& Config::assignSlot(size_t slot)
+    {
+        if (_loading != nullptr) {
+            return _loading->assign(slot);
+        }
+        if (_recording && !(_slotStates[slot] & SLOT_RECORDED)) {
+            ChangeRecord record = { slot, hasValue(slot), _optionValues[slot] };
+            _changes.push_back(std::move(record));
+            _slotStates[slot] |= SLOT_RECORDED;
+        }
+        _slotStates[slot] |= SLOT_VALUE;
+        return _optionValues[slot];
+    }
+
+    void Config::recordChanges()
+    {
+        _changes.clear();
+        _recording = true;
+    }
+
+    void Config::finishChanges(bool commit, std::vector<size_t>& changed)
+    {
+        for (ChangeRecord& record : _changes) {
+            size_t slot = record.slot;
+            _slotStates[slot] &= ~SLOT_RECORDED;
+            if (!commit) {
+                _optionValues[slot] = std::move(record.previous);
+                if (!record.hadValue) {
+                    _slotStates[slot] &= ~SLOT_VALUE;
+                }
+            } else if (hasValue(slot) && (!record.hadValue || record.previous != _optionValues[slot])) {
+                changed.push_back(slot);
+            }
+        }
+        _changes.clear();
+        _recording = false;
+    }
+
+    void Config::beginBatch()
+    {
+        if (_batchDepth++ == 0) {
+            recordChanges();
+        }
+    }
+
+    void Config::endBatch(std::vector<size_t>* changed)
+    {
+        if (--_batchDepth != 0) {
+            return;
+        }
+        resolve();
+        std::vector<size_t> slots;
+        finishChanges(true, slots);
+        if (changed != nullptr) {
+            changed->insert(changed->end(), slots.begin(), slots.end());
+        }
+        notify(slots);
+    }
+
+    void Config::notify(std::vector<size_t>& changed)
+    {
+        if (changed.empty() || _subscriptions.empty()) {
+            return;
+        }
+        const std::deque<std::string>& flags = _flags;
+        std::sort(changed.begin(), changed.end(), [&flags](size_t a, size_t b) {
+            return flags[a] < flags[b];
+        });
+
+        // the callbacks may subscribe and unsubscribe
+        std::vector<Subscription> subscriptions(_subscriptions);
+        std::vector<std::string> matched;
+        for (const Subscription& subscription : subscriptions) {
+            matched.clear();
+            for (size_t slot : changed) {
+                const std::string& flag = _flags[slot];
+                if (subscription.exact ? flag == subscription.prefix : flag.compare(0, subscription.prefix.size(), subscription.prefix) == 0) {
+                    if (subscription.onValue) {
+                        subscription.onValue(flag, _optionValues[slot]);
+                    } else {
+                        matched.push_back(flag);
+                    }
+                }
+            }
+            if (!matched.empty() && subscription.onBatch) {
+                subscription.onBatch(matched);
+            }
+        }
+    }
+
+    size_t Config::subscribe(const std::string& pattern, BatchCallback callback)
+    {
+        Subscription subscription = { _nextSubscription++, pattern, true, ChangeCallback(), std::move(callback) };
+        if (pattern == "*") {
+            subscription.prefix.clear();
+            subscription.exact = false;
+        } else if (pattern.size() > 2 && pattern.compare(pattern.size() - 2, 2, ".*") == 0) {
+            subscription.prefix.resize(pattern.size() - 1);
+            subscription.exact = false;
+        }
+        _subscriptions.push_back(std::move(subscription));
+        return _subscriptions.back().id;
+    }
+
+    bool Config::unsubscribe(size_t id)
+    {
+        for (size_t i = 0; i < _subscriptions.size(); ++i) {
+            if (_subscriptions[i].id == id) {
+                _subscriptions.erase(_subscriptions.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const Value* Config::Layer::find(size_t slot) const
+    {
+        return (slot < index.size() && index[slot] != NO_SLOT) ? &values[index[slot]] : nullptr;
+    }
+
+    Value& Config::Layer::assign(size_t slot)
+    {
+        if (slot >= index.size()) {
+            index.resize(slot + 1, NO_SLOT);
+        }
+        if (index[slot] == NO_SLOT) {
+            index[slot] = values.size();
+            slots.push_back(slot);
+            values.emplace_back();
+        }
+        return values[index[slot]];
+    }
+
+    bool Config::Layer::erase(size_t slot)
+    {
+        if (slot >= index.size() || index[slot] == NO_SLOT) {
+            return false;
+        }
+        // the last value is moved into the gap
+        size_t position = index[slot];
+        size_t last = slots.back();
+        values[position] = std::move(values.back());
+        slots[position] = last;
+        index[last] = position;
+        index[slot] = NO_SLOT;
+        values.pop_back();
+        slots.pop_back();
+        return true;
+    }
+
+    void Config::Layer::clear()
+    {
+        for (size_t slot : slots) {
+            index[slot] = NO_SLOT;
+        }
+        slots.clear();
+        values.clear();
+        malformed = false;
+    }
+
+    size_t Config::SlotTable::acquire(const char* flag, size_t length, size_t hash)
+    {
+        if (!index.empty()) {
+            size_t mask = index.size() - 1;
+            for (size_t bucket = hash & mask; index[bucket] != 0; bucket = (bucket + 1) & mask) {
+                size_t slot = index[bucket] - 1;
+                if (flagHashes[slot] == hash && flags[slot].size() == length && memcmp(flags[slot].data(), flag, length) == 0) {
+                    return slot;
+                }
+            }
+        }
+
+        // keep the load factor of the hash index below 1/2, like the slot store
+        if ((flags.size() + 1) * 2 > index.size()) {
+            std::vector<size_t> newIndex(index.empty() ? 16 : index.size() * 2, 0);
+            size_t mask = newIndex.size() - 1;
+            for (size_t i = 0; i < flags.size(); ++i) {
+                size_t bucket = flagHashes[i] & mask;
+                while (newIndex[bucket] != 0) {
+                    bucket = (bucket + 1) & mask;
+                }
+                newIndex[bucket] = i + 1;
+            }
+            index.swap(newIndex);
+        }
+        size_t slot = flags.size();
+        flags.emplace_back(flag, length);
+        flagHashes.push_back(hash);
+        size_t mask = index.size() - 1;
+        size_t bucket = hash & mask;
+        while (index[bucket] != 0) {
+            bucket = (bucket + 1) & mask;
+        }
+        index[bucket] = slot + 1;
+        return slot;
+    }
+
+    static const char* layerName(Config::Source source)
+    {
+        switch (source) {
+            case Config::Source::DEFAULT: return "default";
+            case Config::Source::ARGUMENT: return "arguments";
+            case Config::Source::OVERRIDE: return "override";
+            default: return "";
+        }
+    }
+
+    size_t Config::acquireLayer(Source source, const std::string& name)
+    {
+        for (size_t layer = 0; layer < _layers.size(); ++layer) {
+            if (_layers[layer].source == source && _layers[layer].name == name) {
+                return layer;
+            }
+        }
+        size_t layer = _layers.size();
+        _layers.emplace_back();
+        _layers[layer].source = source;
+        _layers[layer].name = name;
+
+        // a layer takes precedence over the layers of the same source added before
+        size_t position = _layerOrder.size();
+        while (position > 0 && _layers[_layerOrder[position - 1]].source > source) {
+            --position;
+        }
+        _layerOrder.insert(_layerOrder.begin() + position, layer);
+        for (size_t i = position; i < _layerOrder.size(); ++i) {
+            _layers[_layerOrder[i]].rank = i;
+        }
+        return layer;
+    }
+
+    void Config::replaceLayer(size_t layer, Layer& values)
+    {
+        // the slots dropped from the layer and the slots assigned by the new values
+        Layer& target = _layers[layer];
+        for (size_t slot : target.slots) {
+            markPending(layer, slot);
+        }
+        for (size_t slot : values.slots) {
+            markPending(layer, slot);
+        }
+        // the values are moved rather than the buffers swapped, each layer keeps its capacity
+        target.clear();
+        for (size_t i = 0; i < values.slots.size(); ++i) {
+            target.assign(values.slots[i]) = std::move(values.values[i]);
+        }
+        values.clear();
+    }
+
+    void Config::mergeLayer(size_t layer, Layer& values)
+    {
+        Layer& target = _layers[layer];
+        for (size_t i = 0; i < values.slots.size(); ++i) {
+            target.assign(values.slots[i]) = std::move(values.values[i]);
+            markPending(layer, values.slots[i]);
+        }
+    }
+
+    void Config::markPending(size_t layer, size_t slot)
+    {
+        // the value of a layer with higher precedence is not affected
+        size_t provider = _slotLayers[slot];
+        if (provider != NO_SLOT && _layers[provider].rank > _layers[layer].rank) {
+            return;
+        }
+        if (!(_slotStates[slot] & SLOT_PENDING)) {
+            _slotStates[slot] |= SLOT_PENDING;
+            _pendingSlots.push_back(slot);
+        }
+    }
+
+    void Config::resolve()
+    {
+        for (size_t slot : _pendingSlots) {
+            _slotStates[slot] &= ~SLOT_PENDING;
+            size_t provider = NO_SLOT;
+            const Value* value = nullptr;
+            for (size_t i = _layerOrder.size(); i > 0 && value == nullptr; --i) {
+                provider = _layerOrder[i - 1];
+                value = _layers[provider].find(slot);
+            }
+            if (value != nullptr) {
+                assignSlot(slot) = *value;
+                _slotLayers[slot] = provider;
+            } else if (_slotLayers[slot] != NO_SLOT) {
+                // no source provides the value anymore
+                assignSlot(slot) = Value::unknown();
+                _slotStates[slot] &= ~SLOT_VALUE;
+                _slotLayers[slot] = NO_SLOT;
+            }
+        }
+        _pendingSlots.clear();
+    }
+
+    bool Config::overrideValue(const std::string& flag, const Value& value)
+    {
+        size_t slot = acquireSlot(flag);
+        if (hasOption(slot) && _options[slot].type() != Value::DataType::UNKNOWN && _options[slot].type() != value.type()) {
+            log(LogLevel::WARNING, flag, "cannot override the value, data type mismatch");
+            return false;
+        }
+        beginBatch();
+        size_t layer = acquireLayer(Source::OVERRIDE, layerName(Source::OVERRIDE));
+        _layers[layer].assign(slot) = value;
+        markPending(layer, slot);
+        endBatch();
+        return true;
+    }
+
+    bool Config::clearOverride(const std::string& flag)
+    {
+        size_t slot = lookupSlot(flag);
+        size_t layer = acquireLayer(Source::OVERRIDE, layerName(Source::OVERRIDE));
+        if (slot == NO_SLOT || !_layers[layer].erase(slot)) {
+            return false;
+        }
+        beginBatch();
+        markPending(layer, slot);
+        endBatch();
+        return true;
+    }
+
+    Config::Source Config::source(const std::string& flag) const
+    {
+        // loading an entry of an attached snapshot does not change the configuration
+        size_t slot = const_cast<Config*>(this)->lookupSlot(flag);
+        if (slot == NO_SLOT || !hasValue(slot) || _slotLayers[slot] == NO_SLOT) {
+            return Source::NONE;
+        }
+        return _layers[_slotLayers[slot]].source;
+    }
+
+    const std::string& Config::sourceName(const std::string& flag) const
+    {
+        static const std::string none;
+        size_t slot = const_cast<Config*>(this)->lookupSlot(flag);
+        if (slot == NO_SLOT || !hasValue(slot) || _slotLayers[slot] == NO_SLOT) {
+            return none;
+        }
+        return _layers[_slotLayers[slot]].name;
+    }
+
+    size_t Config::loadSlot(Layer& values, const char* flag, size_t length, size_t hash)
+    {
+        if (values.slotTable != nullptr) {
+            return values.slotTable->acquire(flag, length, hash);
+        }
+        return acquireSlot(flag, length, hash);
+    }
+
+    const std::string& Config::loadedFlag(const Layer& values, size_t slot) const
+    {
+        return (values.slotTable != nullptr) ? values.slotTable->flags[slot] : _flags[slot];
+    }
+
+    const Config::Option* Config::loadedOption(const Layer& values, size_t slot) const
+    {
+        if (values.slotTable == nullptr) {
+            return hasOption(slot) ? &_options[slot] : nullptr;
+        }
+        // the slot store is only read, the flag is looked up without adding a slot
+        const std::string& flag = values.slotTable->flags[slot];
+        size_t storeSlot = findSlot(flag.data(), flag.size(), values.slotTable->flagHashes[slot]);
+        return (storeSlot != NO_SLOT && hasOption(storeSlot)) ? &_options[storeSlot] : nullptr;
+    }
+
+    bool Config::hasOption(size_t slot) const
+    {
+        return (_slotStates[slot] & SLOT_OPTION) != 0;
+    }
+
+    bool Config::hasValue(size_t slot) const
+    {
+        return (_slotStates[slot] & SLOT_VALUE) != 0;
+    }
+
+    const std::vector<size_t>& Config::sortedSlots()
+    {
+        // slots are never released, so the permutation is only outdated when slots are added
+        if (_sortedSlots.size() != _flags.size()) {
+            _sortedSlots.resize(_flags.size());
+            for (size_t i = 0; i < _sortedSlots.size(); ++i) {
+                _sortedSlots[i] = i;
+            }
+            const std::deque<std::string>& flags = _flags;
+            std::sort(_sortedSlots.begin(), _sortedSlots.end(), [&flags](size_t a, size_t b) {
+                return flags[a] < flags[b];
+            });
+        }
+        return _sortedSlots;
+    }
+
+    size_t Config::translateShortflag(const char* shortflag, size_t length) const
+    {
+        if (_shortflagIndex.empty() || length == 0) {
+            return NO_SLOT;
+        }
+        size_t mask = _shortflagIndex.size() - 1;
+        for (size_t bucket = hashFlag(shortflag, length) & mask; _shortflagIndex[bucket] != 0; bucket = (bucket + 1) & mask) {
+            const std::string& candidate = _options[_shortflagIndex[bucket] - 1]._shortflag;
+            if (candidate.size() == length && memcmp(candidate.data(), shortflag, length) == 0) {
+                return _shortflagIndex[bucket] - 1;
+            }
+        }
+        return NO_SLOT;
+    }
+
+    void Config::indexShortflag(size_t slot)
+    {
+        const std::string& shortflag = _options[slot]._shortflag;
+        if (shortflag.empty()) {
+            return;
+        }
+
+        // duplicates are chained after the first option registered with the short flag
+        size_t owner = translateShortflag(shortflag.data(), shortflag.size());
+        if (owner != NO_SLOT) {
+            while (_shortflagNext[owner] != NO_SLOT) {
+                owner = _shortflagNext[owner];
+            }
+            _shortflagNext[owner] = slot;
+            ++_duplicateShortflags;
+            log(LogLevel::ERROR, _flags[slot], "duplicate short flags (" + shortflag + ")");
+            return;
+        }
+
+        // keep the load factor of the hash index below 1/2
+        if ((_shortflagCount + 1) * 2 > _shortflagIndex.size()) {
+            std::vector<size_t> oldIndex(_shortflagIndex.empty() ? 16 : _shortflagIndex.size() * 2, 0);
+            oldIndex.swap(_shortflagIndex);
+            size_t mask = _shortflagIndex.size() - 1;
+            for (size_t entry : oldIndex) {
+                if (entry != 0) {
+                    const std::string& key = _options[entry - 1]._shortflag;
+                    size_t bucket = hashFlag(key.data(), key.size()) & mask;
+                    while (_shortflagIndex[bucket] != 0) {
+                        bucket = (bucket + 1) & mask;
+                    }
+                    _shortflagIndex[bucket] = entry;
+                }
+            }
+        }
+
+        size_t mask = _shortflagIndex.size() - 1;
+        size_t bucket = hashFlag(shortflag.data(), shortflag.size()) & mask;
+        while (_shortflagIndex[bucket] != 0) {
+            bucket = (bucket + 1) & mask;
+        }
+        _shortflagIndex[bucket] = slot + 1;
+        ++_shortflagCount;
+    }
+
+    void Config::unindexShortflag(size_t slot)
+    {
+        const std::string& shortflag = _options[slot]._shortflag;
+        size_t owner = translateShortflag(shortflag.data(), shortflag.size());
+        if (owner == NO_SLOT) {
+            return;
+        }
+
+        // a duplicate is simply unlinked from the chain
+        if (owner != slot) {
+            while (_shortflagNext[owner] != NO_SLOT && _shortflagNext[owner] != slot) {
+                owner = _shortflagNext[owner];
+            }
+            _shortflagNext[owner] = _shortflagNext[slot];
+            _shortflagNext[slot] = NO_SLOT;
+            --_duplicateShortflags;
+            return;
+        }
+
+        size_t mask = _shortflagIndex.size() - 1;
+        size_t bucket = hashFlag(shortflag.data(), shortflag.size()) & mask;
+        while (_shortflagIndex[bucket] != slot + 1) {
+            bucket = (bucket + 1) & mask;
+        }
+
+        // the next duplicate (if any) takes over the bucket
+        if (_shortflagNext[slot] != NO_SLOT) {
+            _shortflagIndex[bucket] = _shortflagNext[slot] + 1;
+            _shortflagNext[slot] = NO_SLOT;
+            --_duplicateShortflags;
+            return;
+        }
+
+        // backward-shift deletion keeps the probe sequences intact without tombstones
+        size_t hole = bucket;
+        for (size_t next = (hole + 1) & mask; _shortflagIndex[next] != 0; next = (next + 1) & mask) {
+            const std::string& key = _options[_shortflagIndex[next] - 1]._shortflag;
+            size_t home = hashFlag(key.data(), key.size()) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                _shortflagIndex[hole] = _shortflagIndex[next];
+                hole = next;
+            }
+        }
+        _shortflagIndex[hole] = 0;
+        --_shortflagCount;
+    }
+
+    bool Config::sharesShortflag(size_t slot) const
+    {
+        const std::string& shortflag = _options[slot]._shortflag;
+        if (shortflag.empty()) {
+            return false;
+        }
+        return (translateShortflag(shortflag.data(), shortflag.size()) != slot || _shortflagNext[slot] != NO_SLOT);
+    }
+
+    void Config::countDiagnostics(unsigned char before, unsigned char after)
+    {
+        const unsigned char errors = Option::NO_DEFAULT_VALUE;
+        const unsigned char warnings = Option::NO_DESCRIPTION | Option::NO_SHORTFLAG;
+        _formatErrors += ((after & errors) != 0);
+        _formatErrors -= ((before & errors) != 0);
+        _formatWarnings += ((after & warnings) != 0);
+        _formatWarnings -= ((before & warnings) != 0);
+    }
+
+    Config::Option& Config::option(const std::string& flag)
+    {
+        size_t slot = acquireSlot(flag);
+        if (!hasOption(slot)) {
+            _options[slot] = Config::Option();
+            _options[slot]._config = this;
+            _options[slot]._slot = slot;
+            _slotStates[slot] |= SLOT_OPTION;
+            countDiagnostics(0, _options[slot]._diagnostics);
+        }
+        return _options[slot];
+    }
+
+    bool Config::remove(const std::string& flag)
+    {
+        size_t slot = lookupSlot(flag);
+        if (slot != NO_SLOT && hasOption(slot)){
+            unindexShortflag(slot);
+            countDiagnostics(_options[slot]._diagnostics, 0);
+            _options[slot] = Config::Option();
+            _slotStates[slot] &= ~SLOT_OPTION;
+            return true;
+        }
+        return false;
+    }
+
+    void Config::setDefaultValues()
+    {
+        for (size_t slot = 0; slot < _flags.size(); ++slot) {
+            if (hasOption(slot)) {
+                assignSlot(slot) = _options[slot].defaultValue();
+            }
+        }
+    }
+
+    void Config::log(const LogLevel logType)
+    {
+        _logLevel = logType;
+    }
+
+    void Config::log(FILE* fd)
+    {
+        fprintf(fd, "\n[[[  %s  ]]]\n\n", "PARSE LOG");
+        for (auto && logline : _log) {
+            fprintf(fd, "%s\n", logline.c_str());
+        }
+    }
+
+    void Config::log(Config::LogLevel logType, const std::string& token, const std::string& msg)
+    {
+        log(logType, token.c_str(), msg.c_str());
+    }
+
+    // formats a line of the parse log
+    static std::string logLine(Config::LogLevel logType, const char* token, const char* msg)
+    {
+        const int tagWidth = 16;
+        char tag[tagWidth + 1];
+        char format[tagWidth + 1];
+        std::string logString = "";
+        snprintf(format, tagWidth, "<<<%%%ds>>>", tagWidth - 7);
+        switch (logType) {
+            case Config::LogLevel::INFO:
+                snprintf(tag, tagWidth, format, "INFO");
+                break;
+            case Config::LogLevel::WARNING:
+                snprintf(tag, tagWidth, format, "WARNING");
+                break;
+            case Config::LogLevel::ERROR:
+                snprintf(tag, tagWidth, format, "ERROR");
+                break;
+            default:
+                break;
+        }
+        logString.append(tag).append(" Input \"").append(token).append("\" : ").append(msg);
+        return logString;
+    }
+
+    void Config::log(Config::LogLevel logType, const char* token, const char* msg)
+    {
+        // do don't anything if log level is low
+        if (logType < _logLevel) {
+            return;
+        }
+        _log.emplace_back(logLine(logType, token, msg));
+        if (_verbose) {
+            fprintf(stdout, "%s\n", _log.back().c_str());
+        }
+    }
+
+    void Config::log(Layer& values, Config::LogLevel logType, const std::string& token, const std::string& msg)
+    {
+        if (values.slotTable == nullptr) {
+            log(logType, token.c_str(), msg.c_str());
+        } else if (logType >= _logLevel) {
+            values.slotTable->log.emplace_back(logLine(logType, token.c_str(), msg.c_str()));
+        }
+    }
+
+    // the components of a decimal number token
+    struct DecimalToken {
+        bool negative;          // sign of the number
+        bool special;           // "inf", "infinity" or "nan"
+        bool truncated;         // more than 19 significant digits, mantissa is inexact
+        uint64_t mantissa;      // significant digits as an integer
+        int exponent;           // decimal exponent applied to the mantissa
+    };
+
+    // skips ASCII spaces and tabs around a token
+    static void trimToken(const char*& begin, const char*& end)
+    {
+        while (begin != end && (*begin == ' ' || *begin == '\t')) {
+            ++begin;
+        }
+        while (end != begin && (*(end - 1) == ' ' || *(end - 1) == '\t' || *(end - 1) == '\r')) {
+            --end;
+        }
+    }
+
+    // compares a range with a lower case ASCII keyword, ignoring case
+    static bool equalsIgnoreCase(const char* begin, const char* end, const char* keyword)
+    {
+        for (; begin != end && *keyword != '\0'; ++begin, ++keyword) {
+            char c = (*begin >= 'A' && *begin <= 'Z') ? static_cast<char>(*begin - 'A' + 'a') : *begin;
+            if (c != *keyword) {
+                return false;
+            }
+        }
+        return (begin == end && *keyword == '\0');
+    }
+
+    /* scans a complete decimal number, e.g. "-12", "-.5", "1e-3", "-inf"
+     *
+     * The scanner is locale independent, the whole range must be consumed, and it does not
+     * allocate. It returns false if the range is not a number.
+     */
+    static bool scanDecimal(const char* begin, const char* end, DecimalToken& out)
+    {
+        const char* c = begin;
+        out.negative = false;
+        out.special = false;
+        out.truncated = false;
+        out.mantissa = 0;
+        out.exponent = 0;
+        if (c != end && (*c == '+' || *c == '-')) {
+            out.negative = (*c == '-');
+            ++c;
+        }
+        if (equalsIgnoreCase(c, end, "inf") || equalsIgnoreCase(c, end, "infinity") || equalsIgnoreCase(c, end, "nan")) {
+            out.special = true;
+            return true;
+        }
+        bool digits = false;
+        int significant = 0;
+        for (; c != end && *c >= '0' && *c <= '9'; ++c) {
+            digits = true;
+            if (significant < 19) {
+                out.mantissa = out.mantissa * 10 + static_cast<uint64_t>(*c - '0');
+                significant += (out.mantissa != 0);
+            } else {
+                out.truncated = out.truncated || (*c != '0');
+                ++out.exponent;
+            }
+        }
+        if (c != end && *c == '.') {
+            for (++c; c != end && *c >= '0' && *c <= '9'; ++c) {
+                digits = true;
+                if (significant < 19) {
+                    out.mantissa = out.mantissa * 10 + static_cast<uint64_t>(*c - '0');
+                    significant += (out.mantissa != 0);
+                    --out.exponent;
+                } else {
+                    out.truncated = out.truncated || (*c != '0');
+                }
+            }
+        }
+        if (!digits) {
+            return false;
+        }
+        if (c != end && (*c == 'e' || *c == 'E')) {
+            ++c;
+            bool negativeExponent = false;
+            if (c != end && (*c == '+' || *c == '-')) {
+                negativeExponent = (*c == '-');
+                ++c;
+            }
+            if (c == end || !(*c >= '0' && *c <= '9')) {
+                return false;
+            }
+            int exponent = 0;
+            for (; c != end && *c >= '0' && *c <= '9'; ++c) {
+                // saturate, anything beyond is an overflow / underflow anyway
+                if (exponent < 100000) {
+                    exponent = exponent * 10 + (*c - '0');
+                }
+            }
+            out.exponent += negativeExponent ? -exponent : exponent;
+        }
+        return (c == end);
+    }
+
+    // checks if a token is a complete decimal number
+    static bool isNumeric(const char* token)
+    {
+        DecimalToken decimal;
+        return scanDecimal(token, token + strlen(token), decimal);
+    }
+
+    /* parses an integer token strictly
+     *
+     * Surrounding blanks are ignored, any other trailing character, or a value out of the
+     * range of T, is an error.
+     */
+    template <typename T>
+    static bool parseInteger(const char* begin, const char* end, T& out)
+    {
+        trimToken(begin, end);
+        bool negative = false;
+        if (begin != end && (*begin == '+' || *begin == '-')) {
+            negative = (*begin == '-');
+            ++begin;
+        }
+        if (begin == end) {
+            return false;
+        }
+        const uint64_t limit = negative ?
+                static_cast<uint64_t>(-(std::numeric_limits<T>::min() + 1)) + 1 :
+                static_cast<uint64_t>(std::numeric_limits<T>::max());
+        uint64_t magnitude = 0;
+        for (; begin != end; ++begin) {
+            if (!(*begin >= '0' && *begin <= '9')) {
+                return false;
+            }
+            uint64_t digit = static_cast<uint64_t>(*begin - '0');
+            if (magnitude > (limit - digit) / 10) {
+                return false;
+            }
+            magnitude = magnitude * 10 + digit;
+        }
+        out = negative ? static_cast<T>(-static_cast<T>(magnitude - 1) - 1) : static_cast<T>(magnitude);
+        return true;
+    }
+
+    /* strtod in the "C" locale
+     *
+     * The locale is created once and never released. It is independent of setlocale(), which
+     * may be called by another thread while config files are loaded concurrently. Platforms
+     * without strtod_l() use strtod with the decimal point of the current locale, the string
+     * is modified for that.
+     */
+    static double strtodC(char* str, char** endptr)
+    {
+#if defined(MINICONF_STRTOD_L_SUPPORT) && defined(_WIN32)
+        static const _locale_t locale = _create_locale(LC_ALL, "C");
+        if (locale != nullptr) {
+            return _strtod_l(str, endptr, locale);
+        }
+#elif defined(MINICONF_STRTOD_L_SUPPORT)
+        static const locale_t locale = newlocale(LC_ALL_MASK, "C", static_cast<locale_t>(0));
+        if (locale != static_cast<locale_t>(0)) {
+            return strtod_l(str, endptr, locale);
+        }
+#endif
+        const char* decimalPoint = localeconv()->decimal_point;
+        if (decimalPoint[0] != '.' && decimalPoint[0] != '\0' && decimalPoint[1] == '\0') {
+            char* point = strchr(str, '.');
+            if (point != nullptr) {
+                *point = decimalPoint[0];
+            }
+        }
+        return strtod(str, endptr);
+    }
+
+    /* parses a floating point token strictly
+     *
+     * Numbers with at most 19 significant digits and a small exponent are converted exactly 
+     * with a single multiplication or division, other numbers fall back to strtod in the "C"
+     * locale (see strtodC()). Overflow to infinity is an error.
+     */
+    static bool parseNumber(const char* begin, const char* end, double& out)
+    {
+        static const double powersOfTen[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        trimToken(begin, end);
+        DecimalToken decimal;
+        if (!scanDecimal(begin, end, decimal)) {
+            return false;
+        }
+        if (decimal.special) {
+            const char* c = begin + ((*begin == '+' || *begin == '-') ? 1 : 0);
+            double special = (*c == 'n' || *c == 'N') ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+            out = decimal.negative ? -special : special;
+            return true;
+        }
+
+        // fast path, both the mantissa and the power of ten are exact doubles
+        if (!decimal.truncated && decimal.mantissa <= (static_cast<uint64_t>(1) << 53) &&
+                decimal.exponent >= -22 && decimal.exponent <= 22) {
+            double value = static_cast<double>(decimal.mantissa);
+            value = (decimal.exponent < 0) ? value / powersOfTen[-decimal.exponent] : value * powersOfTen[decimal.exponent];
+            out = decimal.negative ? -value : value;
+            return true;
+        }
+
+        // slow path, strtod needs a terminated copy, only tokens with hundreds of digits are
+        // copied to the heap
+        char buffer[128];
+        std::string longToken;
+        size_t length = static_cast<size_t>(end - begin);
+        char* copy = buffer;
+        if (length >= sizeof(buffer)) {
+            longToken.assign(begin, end);
+            copy = &longToken[0];
+        } else {
+            memcpy(buffer, begin, length);
+            buffer[length] = '\0';
+        }
+        char* endptr = nullptr;
+        double value = strtodC(copy, &endptr);
+        if (endptr != copy + length || value == std::numeric_limits<double>::infinity() ||
+                value == -std::numeric_limits<double>::infinity()) {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+    /* formats a number so that it reads back exactly, with '.' as the decimal point
+     *
+     * 15 significant digits are tried first so that e.g. 0.1 is not written as 
+     * 0.10000000000000001, 17 digits are used when 15 do not read back the same number.
+     */
+    static void formatNumber(char* buffer, size_t size, double number)
+    {
+        for (int precision = 15; precision <= 17; precision += 2) {
+            snprintf(buffer, size, "%.*g", precision, number);
+            for (char* c = buffer; *c != '\0'; ++c) {
+                if (*c == ',') {
+                    *c = '.';
+                }
+            }
+            double parsed;
+            if (parseNumber(buffer, buffer + strlen(buffer), parsed) && parsed == number) {
+                return;
+            }
+        }
+    }
+
+    Config::TokenType Config::getTokenType(const char* token)
+    {
+        // get token type:
+        // starts with "--" - flag
+        // starts with "-" - shortflag/value (negative number)
+        // otherwise value
+        if (token[0] == '\0') return TokenType::UNKNOWN;
+        if (token[0] == '-') {
+            if (isNumeric(token)) {
+                return TokenType::VALUE;
+            }
+            return (token[1] == '-') ? TokenType::FLAG : TokenType::SHORTFLAG;
+        }
+        return TokenType::VALUE;
+    }
+
+    bool Config::findOption(const std::string& flag)
+    {
+        size_t slot = lookupSlot(flag);
+        return (slot != NO_SLOT && hasOption(slot));
+    }
+
+    Config::Option* Config::getOption(const char* token, Config::TokenType tokenType)
+    {
+        size_t slot = NO_SLOT;
+        if (tokenType == TokenType::FLAG) {
+            slot = lookupSlot(token + 2, strlen(token + 2));
+        } else if (tokenType == TokenType::SHORTFLAG) {
+            // the short flags of an attached snapshot are indexed once its entries are loaded
+            slot = translateShortflag(token + 1, strlen(token + 1));
+            if (slot == NO_SLOT && !_mappedSnapshots.empty()) {
+                loadMappedEntries();
+                slot = translateShortflag(token + 1, strlen(token + 1));
+            }
+            // an unknown short flag is looked up as a long flag
+            if (slot == NO_SLOT) {
+                slot = lookupSlot(token + 1, strlen(token + 1));
+            }
+        }
+        if (slot != NO_SLOT && hasOption(slot)) {
+            return &(_options[slot]);
+        }
+        return nullptr;
+    }
+
+    // compares a range with a keyword
+    static bool equals(const char* begin, const char* end, const char* keyword)
+    {
+        size_t length = strlen(keyword);
+        return (static_cast<size_t>(end - begin) == length && memcmp(begin, keyword, length) == 0);
+    }
+
+    /* Builds an array value from its elements
+     *
+     * All elements must have the element type of arrayType, or the same type if arrayType is
+     * UNKNOWN, otherwise an unknown value is returned. An empty array of unknown type is an
+     * array of strings.
+     */
+    static Value makeArray(Value::DataType arrayType, const std::vector<Value>& elements)
+    {
+        Value::DataType elementType = Value::elementType(arrayType);
+        if (arrayType == Value::DataType::UNKNOWN) {
+            elementType = elements.empty() ? Value::DataType::STRING : elements[0].type();
+        }
+        for (const Value& element : elements) {
+            if (element.type() != elementType) {
+                return Value();
+            }
+        }
+        switch (elementType) {
+            case Value::DataType::INT: {
+                std::vector<int> items;
+                for (const Value& element : elements) {
+                    items.push_back(element.getInt());
+                }
+                return Value(items);
+            }
+            case Value::DataType::NUMBER: {
+                std::vector<double> items;
+                for (const Value& element : elements) {
+                    items.push_back(element.getNumber());
+                }
+                return Value(items);
+            }
+            case Value::DataType::BOOL: {
+                std::vector<bool> items;
+                for (const Value& element : elements) {
+                    items.push_back(element.getBoolean());
+                }
+                return Value(items);
+            }
+            case Value::DataType::STRING: {
+                std::vector<std::string> items;
+                for (const Value& element : elements) {
+                    items.push_back(element.getString());
+                }
+                return Value(items);
+            }
+            default:
+                return Value();
+        }
+    }
+
+    // splits an array value into its elements
+    static void splitArray(const Value& array, std::vector<Value>& elements)
+    {
+        switch (array.type()) {
+            case Value::DataType::INT_ARRAY:
+                for (int item : array.getIntArray()) {
+                    elements.push_back(Value(item));
+                }
+                break;
+            case Value::DataType::NUMBER_ARRAY:
+                for (double item : array.getNumberArray()) {
+                    elements.push_back(Value(item));
+                }
+                break;
+            case Value::DataType::BOOL_ARRAY:
+                for (bool item : array.getBooleanArray()) {
+                    elements.push_back(Value(item));
+                }
+                break;
+            case Value::DataType::STRING_ARRAY:
+                for (const char* item : array.getStringArray()) {
+                    elements.push_back(Value(item));
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    Value Config::parseValue(const char* token, Value::DataType dataType)
+    {
+        return parseValue(token, token + strlen(token), dataType);
+    }
+
+    Value Config::parseValue(const char* begin, const char* end, Value::DataType dataType)
+    {
+        // array elements are separated by commas, blanks around an element are ignored
+        Value::DataType elementType = Value::elementType(dataType);
+        if (elementType != Value::DataType::UNKNOWN) {
+            std::vector<Value> elements;
+            std::string unquoted;
+            trimToken(begin, end);
+            while (begin != end) {
+                const char* elementBegin = begin;
+                const char* elementEnd = end;
+                trimToken(elementBegin, elementEnd);
+                if (elementBegin != elementEnd && *elementBegin == '"') {
+                    // a quoted element may contain commas, a quote inside it is written as two quotes
+                    unquoted.clear();
+                    const char* c = elementBegin + 1;
+                    for (; c != end && (*c != '"' || (c + 1 != end && c[1] == '"')); ++c) {
+                        unquoted.push_back(*c);
+                        c += (*c == '"') ? 1 : 0;
+                    }
+                    if (c == end) {
+                        return Value::unknown();
+                    }
+                    // only blanks may follow the closing quote
+                    begin = c + 1;
+                    while (begin != end && (*begin == ' ' || *begin == '\t')) {
+                        ++begin;
+                    }
+                    if (begin != end && *begin != ',') {
+                        return Value::unknown();
+                    }
+                    elements.push_back(parseValue(unquoted.data(), unquoted.data() + unquoted.size(), elementType));
+                } else {
+                    const char* comma = static_cast<const char*>(memchr(begin, ',', static_cast<size_t>(end - begin)));
+                    elementEnd = (comma != nullptr) ? comma : end;
+                    trimToken(elementBegin, elementEnd);
+                    elements.push_back(parseValue(elementBegin, elementEnd, elementType));
+                    begin = (comma != nullptr) ? comma : end;
+                }
+                if (elements.back().isEmpty()) {
+                    return Value::unknown();
+                }
+                begin = (begin != end) ? begin + 1 : end;
+            }
+            return makeArray(dataType, elements);
+        }
+        if (dataType == Value::DataType::INT) {
+            int v;
+            bool success = parseInteger(begin, end, v);
+            return success ? Value(v) : Value::unknown();
+        }
+        if (dataType == Value::DataType::INT64) {
+            int64_t v;
+            bool success = parseInteger(begin, end, v);
+            return success ? Value(v) : Value::unknown();
+        }
+        if (dataType == Value::DataType::NUMBER) {
+            double v;
+            bool success = parseNumber(begin, end, v);
+            return success ? Value(v) : Value();
+
+        }
+        if (dataType == Value::DataType::BOOL) {
+            if (equals(begin, end, "false") || equals(begin, end, "False") || equals(begin, end, "FALSE") ||
+                    equals(begin, end, "F") || equals(begin, end, "f")) {
+                return Value(false);
+            }
+            return Value(true);
+
+        }
+        if (dataType == Value::DataType::STRING) {
+            return Value(begin, static_cast<size_t>(end - begin));
+        }
+        return Value::unknown(); // fool-proof, return an unknown
+    }
+
+    static Config::LogLevel worseLevel(const Config::LogLevel& a, const Config::LogLevel& b)
+    {
+        return ((a) < (b)) ? (b) : (a);
+    }
+
+    Config::LogLevel Config::checkFormat()
+    {
+        LogLevel errorLv = LogLevel::INFO;
+
+        // format issues are evaluated when options are defined, the options only need to
+        // be scanned to report them
+        if (_formatErrors != 0 || _formatWarnings != 0) {
+            for (size_t slot : sortedSlots()) {
+                if (!hasOption(slot) || _options[slot]._diagnostics == 0) {
+                    continue;
+                }
+                unsigned char diagnostics = _options[slot]._diagnostics;
+                // check for error
+                if (diagnostics & Option::NO_DEFAULT_VALUE) {
+                    log(LogLevel::ERROR, _flags[slot], "default value is not defined");
+                }
+                // check for warnings
+                if (diagnostics & Option::NO_DESCRIPTION) {
+                    log(LogLevel::WARNING, _flags[slot], "no description text for argument");
+                }
+                if (diagnostics & Option::NO_SHORTFLAG) {
+                    log(LogLevel::WARNING, _flags[slot], "no short flag is provided");
+                }
+            }
+        }
+        if (_formatWarnings != 0) {
+            errorLv = worseLevel(errorLv, LogLevel::WARNING);
+        }
+        // duplicate short flags are reported when they are registered
+        if (_formatErrors != 0 || _duplicateShortflags != 0) {
+            errorLv = worseLevel(errorLv, LogLevel::ERROR);
+        }
+        if (_description.empty()) {
+            log(LogLevel::WARNING, "", "No program description text is provided");
+            errorLv = worseLevel(errorLv, LogLevel::WARNING);
+        }
+        return errorLv;
+    }
+
+    // Validate User Input
+    Config::LogLevel Config::validate()
+    {
+        LogLevel errorLv = LogLevel::INFO;
+
+        // one pass over the store:
+        // remove all the hidden values, scan for all option values,
+        // and scan for all remaining options are defined
+        for (size_t slot : sortedSlots()) {
+            if (hasOption(slot) && _options[slot].hidden()) {
+                _optionValues[slot] = Value::unknown();
+                _slotStates[slot] &= ~SLOT_VALUE;
+            } else if (hasValue(slot)) {
+                if (_optionValues[slot].isEmpty()) {
+                    log(LogLevel::ERROR, _flags[slot], "option contains invalid value");
+                    errorLv = worseLevel(errorLv, LogLevel::ERROR);
+                }
+            } else if (hasOption(slot)) {
+                log(LogLevel::ERROR, _flags[slot], "option is undefined");
+                errorLv = worseLevel(errorLv, LogLevel::ERROR);
+            }
+        }
+        return errorLv;
+    }
+
+    bool Config::parse(int argc, char **argv)
+    {
+        // subscribers are notified once all sources have been parsed
+        beginBatch();
+        bool success = parseArguments(argc, argv);
+        endBatch();
+        return success;
+    }
+
+    bool Config::parseArguments(int argc, char **argv)
+    {
+        // Extract executable name
+        const char* exeName = argv[0];
+        for (const char* c = argv[0]; *c != '\0'; ++c) {
+            if (*c == '/' || *c == '\\') {
+                exeName = c + 1;
+            }
+        }
+        _exeName.assign(exeName);
+
+        // check format of the option parser
+        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
+        LogLevel checkFormatResult = checkFormat();
+        if (checkFormatResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
+            log();
+            printf("\nFatal Error: Option format validation failed, abort.\n\n");
+            return false;
+        }
+
+        // Value Precedence, each source is loaded into its own layer:
+        // (1) Default Value
+        // (2) Config File Settings (overwrites default values)
+        // (3) Command Line Arguments (overwrites default values and config file)
+        // (4) Overrides set at runtime
+        // the option values are resolved once all layers are loaded
+
+        // * Set Default Values
+        _loading = &_scratchLayer;
+        setDefaultValues();
+        _loading = nullptr;
+        replaceLayer(acquireLayer(Source::DEFAULT, layerName(Source::DEFAULT)), _scratchLayer);
+
+        // * Load Config File before scanning for other arguments
+        // case 1: only config file is defined, flag is not necessary
+        // case 2: check if config flag has been defined
+        if (_loadConfig) {
+            for (int i = 1; i < argc - 1; ++i) {
+                if ((strcmp(argv[i], "--config") == 0 || strcmp(argv[i], "-cfg") == 0) &&
+                        getTokenType(argv[i + 1]) == TokenType::VALUE) {
+                    config(argv[i + 1]);
+                }
+            }
+        }
+
+        // start normal parsing
+        // the slot and data type of the option waiting for a value, unrecognized long flags
+        // are captured as "stray" string values
+        size_t currentSlot = NO_SLOT;
+        Value::DataType currentType = Value::DataType::UNKNOWN;
+        // array options assigned by an earlier argument, the elements of repeated flags are appended
+        std::vector<size_t> arraySlots;
+        Layer& arguments = _scratchLayer;
+        _loading = &arguments;
+        for (int i = 1; i < argc; ++i) {
+            TokenType currentTokenType = getTokenType(argv[i]);
+            if (currentTokenType == TokenType::UNKNOWN) {
+                log(LogLevel::ERROR, argv[i], "unknown input");
+            } else if (currentTokenType == TokenType::FLAG || currentTokenType == TokenType::SHORTFLAG) {
+                Option* currentOption = getOption(argv[i], currentTokenType);
+                currentSlot = NO_SLOT;
+                if (currentOption) {
+                    currentSlot = currentOption->_slot;
+                    currentType = currentOption->type();
+                } else {
+                    log(LogLevel::WARNING, argv[i], "unrecognized flag");
+                    if (currentTokenType == TokenType::FLAG) {
+                        currentSlot = acquireSlot(argv[i] + 2, strlen(argv[i] + 2));
+                        currentType = Value::DataType::STRING;
+                    }
+                }
+                // special case - if the option type is bool, set to true by default
+                if (currentSlot != NO_SLOT && currentType == Value::DataType::BOOL) {
+                    assignSlot(currentSlot) = true;
+                }
+            } else if (currentTokenType == TokenType::VALUE) {
+                if (currentSlot != NO_SLOT) {
+                    // parse the value according to default data type
+                    Value newValue = parseValue(argv[i], currentType);
+                    // if value cannot be parsed
+                    if (newValue.isEmpty()) {
+                        log(LogLevel::WARNING, argv[i], "unvalid value type is provided");
+                    } else if (newValue.isArray() && std::find(arraySlots.begin(), arraySlots.end(), currentSlot) != arraySlots.end()) {
+                        std::vector<Value> elements;
+                        splitArray(*arguments.find(currentSlot), elements);
+                        splitArray(newValue, elements);
+                        assignSlot(currentSlot) = makeArray(currentType, elements);
+                        log(LogLevel::INFO, argv[i], "value parsed successfully, appended to the array");
+                    } else {
+                        // assign parsed values
+                        if (newValue.isArray()) {
+                            arraySlots.push_back(currentSlot);
+                        }
+                        assignSlot(currentSlot) = std::move(newValue);
+                        log(LogLevel::INFO, argv[i], "value parsed successfully");
+                    }
+                    // reset current option flag -> ready for a new flag
+                    currentSlot = NO_SLOT;
+                } else {
+                    // stray arguments, ignore
+                    log(LogLevel::WARNING, argv[i], "unassociated argument is not stored");
+                }
+            }
+        }
+        _loading = nullptr;
+        replaceLayer(acquireLayer(Source::ARGUMENT, layerName(Source::ARGUMENT)), arguments);
+        resolve();
+
+        // if contains help and auto-help is enabled, display help message
+        if (contains("help") && (*this)["help"].getBoolean() && _autoHelp) {
+            help();
+        }
+
+        // validate user inputs
+        // remove all hidden options
+        // reserved words should not be displayed as normal config values
+
+        // if fatal error occurs and log level is not "NONE" (NONE = ignore errors)
+        LogLevel validateResult = validate();
+        if (validateResult >= LogLevel::ERROR && _logLevel <= LogLevel::ERROR) {
+            log();
+            printf("\nFatal Error: Option format validation failed, abort.\n\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    void Config::help(FILE* fd)
+    {
+        loadMappedEntries();
+
+        // print program description
+        if (!_description.empty()) {
             fprintf(fd, "\n");
             if (!_exeName.empty()) {
                 fprintf(fd, "[[[  %s  ]]]\n\n    ", _exeName.c_str());
             }
-            fprintf(fd, "%s\n\n", _description.c_str());
+            fprintf(fd, "%s\n\n", _description.c_str());
+        }
+
+        // print usage
+        usage();
+        // print help
+        fprintf(fd, "\n[[[  %s  ]]]\n\n", "HELP");
+        for (size_t slot : sortedSlots()) {
+            if (!hasOption(slot)) {
+                continue;
+            }
+            Option& o = _options[slot];
+            // print short
+            fprintf(fd, "    ");
+            if (!o.shortflag().empty()) {
+                fprintf(fd, "-%s, ", o.shortflag().c_str());
+            }
+            // print long
+            fprintf(fd, "--%s ", o.flag().c_str());
+            // required
+            if (o.required()) {
+                fprintf(fd, "<REQUIRED>");
+            }
+            fprintf(fd, "\n");
+            // print description
+            fprintf(fd, "        ");
+            if (!o.description().empty()) {
+                fprintf(fd, "%s ", o.description().c_str());
+            }
+            // default value
+            if (!o.defaultValue().isEmpty() && !o.hidden()) {
+                fprintf(fd, " ( ");
+                fprintf(fd, "DEFAULT = %s", o.defaultValue().print().c_str());
+                fprintf(fd, " ) ");
+            }
+            fprintf(fd, "\n\n");
+        }
+    }
+
+    void Config::usage(FILE* fd)
+    {
+        loadMappedEntries();
+        fprintf(fd, "\n[[[  %s  ]]]\n\n", "USAGE");
+        char exeTag[256];
+        snprintf(exeTag, 256 - 1, "    %s ", (_exeName.empty()) ? ("<executable>") : (_exeName.c_str()));
+        fprintf(fd, "%s", exeTag);
+        int lineWidth = 0;
+        for (size_t slot : sortedSlots()) {
+            if (!hasOption(slot)) {
+                continue;
+            }
+            Option& o = _options[slot];
+            char argTag[512];
+            snprintf(argTag, 512 - 1, "%s%s%s <%s>%s",
+                     o.required() ? "" : "[",
+                     o.shortflag().empty() ? "--" : "-",
+                     o.shortflag().empty() ? o.flag().c_str() : o.shortflag().c_str(),
+                     o.defaultValue().printType().c_str(),
+                     o.required() ? "" : "]");
+            if (lineWidth + strlen(argTag) >= 80 - 1 - strlen(exeTag)) {
+                fprintf(fd, "\n%*s", static_cast<int>(strlen(exeTag)), " ");
+                lineWidth = 0;
+            }
+            fprintf(fd, "%s ", argTag);
+            lineWidth += strlen(argTag);
+        }
+        fprintf(fd, "\n\n");
+    }
+
+    void Config::description(const std::string& desc)
+    {
+        _description = desc;
+    }
+
+    void Config::enableConfig(bool enabled)
+    {
+        _loadConfig = enabled;
+        if (_autoHelp && !findOption("config")) {
+            option("config").
+                    shortflag("cfg").
+                    defaultValue("").
+                    description("Input configuration file (JSON/CSV)").
+                    required(false).hidden(true);
+        } else {
+            remove("config");
+        }
+
+    }
+
+    void Config::enableHelp(bool enabled)
+    {
+        _autoHelp = enabled;
+        if (_autoHelp && !findOption("help")) {
+            option("help").
+                    shortflag("h").
+                    defaultValue(false).
+                    description("Display the help message").
+                    required(false).hidden(true);
+        } else {
+            remove("help");
+        }
+    }
+
+    void Config::verbose(bool value)
+    {
+        _verbose = value;
+    }
+
+#ifdef MINICONF_JSON_SUPPORT
+    void Config::jsonParser(JSONParser parser)
+    {
+        _jsonParser = parser;
+    }
+#endif
+
+    bool Config::contains(const std::string& flag)
+    {
+        size_t slot = lookupSlot(flag);
+        return (slot != NO_SLOT && hasValue(slot));
+    }
+
+    Value& Config::operator[](const std::string& flag)
+    {
+        return assignSlot(acquireSlot(flag));
+    }
+
+    Value const &Config::operator[](const std::string &flag) const {
+        // loading an entry of an attached snapshot does not change the configuration
+        size_t slot = const_cast<Config*>(this)->lookupSlot(flag);
+        if (slot == NO_SLOT || !hasValue(slot)) {
+            throw std::out_of_range("miniconf::Config: undefined option value " + flag);
+        }
+        return _optionValues[slot];
+    }
+
+    void Config::print(FILE* fd)
+    {
+        loadMappedEntries();
+        fprintf(fd, "\n[[[  %s  ]]]\n\n", "CONFIGURATION");
+
+        printf("|-------------------------|------------|--------------------------------------------------|\n");
+        printf("|           NAME          |    TYPE    |                     VALUE                        |\n");
+        printf("|-------------------------|------------|--------------------------------------------------|\n");
+        for (size_t slot : sortedSlots()) {
+            if (!hasValue(slot)) {
+                continue;
+            }
+            Value& v = _optionValues[slot];
+            if (hasOption(slot)) {
+                fprintf(fd, "| %-23s | %-10s | %-48s |\n", _flags[slot].c_str(), v.printType().c_str(), v.print().c_str());
+            } else {
+                fprintf(fd, "| %-23s | %-10s | %-48s |\n", _flags[slot].c_str(), (v.printType() + "*").c_str(), v.print().c_str());
+            }
+        }
+        printf("|-------------------------|------------|--------------------------------------------------|\n");
+        printf("\n");
+    }
+
+    class Config::Writer
+    {
+        public:
+
+            // writes to an open file
+            explicit Writer(FILE* fd) : _used(0), _fd(fd), _string(nullptr), _good(true) {}
+
+            // appends to a string
+            explicit Writer(std::string* out) : _used(0), _fd(nullptr), _string(out), _good(true) {}
+
+            // the file is not flushed here, see flush()
+            ~Writer()
+            {
+                drain();
+            }
+
+            void put(char c)
+            {
+                if (_used == sizeof(_buffer)) {
+                    drain();
+                }
+                _buffer[_used++] = c;
+            }
+
+            void write(const char* data, size_t size)
+            {
+                if (_used + size > sizeof(_buffer)) {
+                    drain();
+                    if (size > sizeof(_buffer)) {
+                        emit(data, size);
+                        return;
+                    }
+                }
+                memcpy(_buffer + _used, data, size);
+                _used += size;
+            }
+
+            void write(const char* str)
+            {
+                write(str, strlen(str));
+            }
+
+            // writes a CSV field, enclosed in double quotes if it contains a delimiter or a quote
+            void writeCSVField(const char* field, size_t size)
+            {
+                bool quoted = false;
+                for (size_t i = 0; i < size && !quoted; ++i) {
+                    quoted = (field[i] == ',' || field[i] == '"' || field[i] == '\r' || field[i] == '\n');
+                }
+                if (!quoted) {
+                    write(field, size);
+                    return;
+                }
+                put('"');
+                for (size_t i = 0; i < size; ++i) {
+                    if (field[i] == '"') {
+                        put('"');
+                    }
+                    put(field[i]);
+                }
+                put('"');
+            }
+
+#ifdef MINICONF_JSON_SUPPORT
+            // writes a JSON string with the escaping of picojson
+            void writeJSONString(const char* str, size_t size)
+            {
+                put('"');
+                for (size_t i = 0; i < size; ++i) {
+                    char c = str[i];
+                    switch (c) {
+                        case '"': write("\\\"", 2); break;
+                        case '\\': write("\\\\", 2); break;
+                        case '/': write("\\/", 2); break;
+                        case '\b': write("\\b", 2); break;
+                        case '\f': write("\\f", 2); break;
+                        case '\n': write("\\n", 2); break;
+                        case '\r': write("\\r", 2); break;
+                        case '\t': write("\\t", 2); break;
+                        default:
+                            if (static_cast<unsigned char>(c) < 0x20 || c == 0x7f) {
+                                char escaped[7];
+                                snprintf(escaped, sizeof(escaped), "\\u%04x", c & 0xff);
+                                write(escaped, 6);
+                            } else {
+                                put(c);
+                            }
+                            break;
+                    }
+                }
+                put('"');
+            }
+
+            // starts a new line at the given depth of a pretty-printed JSON document
+            void writeJSONIndent(size_t depth)
+            {
+                put('\n');
+                for (size_t i = 0; i < depth * picojson::INDENT_WIDTH; ++i) {
+                    put(' ');
+                }
+            }
+#endif
+
+            // writes the buffered output and flushes the file once the document is complete,
+            // returns false if any write has failed
+            bool flush()
+            {
+                drain();
+                if (_fd != nullptr && fflush(_fd) != 0) {
+                    _good = false;
+                }
+                return _good;
+            }
+
+        private:
+
+            Writer(const Writer&);
+            Writer& operator=(const Writer&);
+
+            // hands a full buffer to the file or string, without flushing the file
+            void drain()
+            {
+                emit(_buffer, _used);
+                _used = 0;
+            }
+
+            void emit(const char* data, size_t size)
+            {
+                if (size == 0) {
+                    return;
+                }
+                if (_string != nullptr) {
+                    _string->append(data, size);
+                } else if (fwrite(data, 1, size, _fd) != size) {
+                    _good = false;
+                }
+            }
+
+            // pending output
+            char _buffer[1 << 14];
+
+            // number of bytes in the buffer
+            size_t _used;
+
+            // output file, or nullptr
+            FILE* _fd;
+
+            // output string, or nullptr
+            std::string* _string;
+
+            // no write has failed
+            bool _good;
+    };
+
+    /* appends a string element of an array field
+     *
+     * Elements which contain a comma or a quote, are empty, or start or end with a blank are
+     * enclosed in double quotes, with the quotes inside doubled, so parseValue() reads them back.
+     */
+    static void appendCSVElement(std::string& joined, const char* element)
+    {
+        size_t size = strlen(element);
+        bool quoted = (size == 0 || element[0] == ' ' || element[0] == '\t' || 
+                element[size - 1] == ' ' || element[size - 1] == '\t' || element[size - 1] == '\r');
+        for (size_t i = 0; i < size && !quoted; ++i) {
+            quoted = (element[i] == ',' || element[i] == '"');
+        }
+        if (!quoted) {
+            joined.append(element, size);
+            return;
+        }
+        joined.push_back('"');
+        for (size_t i = 0; i < size; ++i) {
+            if (element[i] == '"') {
+                joined.push_back('"');
+            }
+            joined.push_back(element[i]);
+        }
+        joined.push_back('"');
+    }
+
+    void Config::writeCSV(Writer& out, size_t root)
+    {
+        char number[32];
+        // flags are written relative to the section
+        size_t prefix = (root == 0) ? 0 : _nodes[root].length + 1;
+        sortNodes();
+        for (size_t node = root; node != NO_SLOT; node = nextNode(node, root)) {
+            size_t slot = _nodes[node].slot;
+            if (slot == NO_SLOT || !hasValue(slot) || _flags[slot].size() < prefix) {
+                continue;
+            }
+            Value& value = _optionValues[slot];
+            out.writeCSVField(_flags[slot].data() + prefix, _flags[slot].size() - prefix);
+            out.put(',');
+            // numbers are written so that they read back exactly, strings are quoted only when necessary
+            switch (value.type()) {
+                case Value::DataType::INT:
+                    snprintf(number, sizeof(number), "%d", value.getInt());
+                    out.write(number);
+                    break;
+                case Value::DataType::INT64:
+                    snprintf(number, sizeof(number), "%lld", static_cast<long long>(value.getInt64()));
+                    out.write(number);
+                    break;
+                case Value::DataType::NUMBER:
+                    formatNumber(number, sizeof(number), value.getNumber());
+                    out.write(number);
+                    break;
+                case Value::DataType::BOOL:
+                    out.write(value.getBoolean() ? "true" : "false");
+                    break;
+                case Value::DataType::STRING:
+                    out.writeCSVField(value.getCharArray(), value.size());
+                    break;
+                case Value::DataType::INT_ARRAY:
+                case Value::DataType::NUMBER_ARRAY:
+                case Value::DataType::BOOL_ARRAY:
+                case Value::DataType::STRING_ARRAY: {
+                    // the elements are joined by commas into one field, see appendCSVElement()
+                    std::string joined;
+                    for (size_t i = 0; i < value.size(); ++i) {
+                        if (i != 0) {
+                            joined.push_back(',');
+                        }
+                        if (value.type() == Value::DataType::INT_ARRAY) {
+                            snprintf(number, sizeof(number), "%d", value.getIntArray()[i]);
+                            joined.append(number);
+                        } else if (value.type() == Value::DataType::NUMBER_ARRAY) {
+                            formatNumber(number, sizeof(number), value.getNumberArray()[i]);
+                            joined.append(number);
+                        } else if (value.type() == Value::DataType::BOOL_ARRAY) {
+                            joined.append(value.getBooleanArray()[i] ? "true" : "false");
+                        } else {
+                            appendCSVElement(joined, value.getStringArray()[i]);
+                        }
+                    }
+                    out.writeCSVField(joined.data(), joined.size());
+                    break;
+                }
+                default:
+                    break;
+            }
+            out.put('\n');
+        }
+    }
+
+#ifdef MINICONF_JSON_SUPPORT
+    /* Writes the option values as nested JSON objects
+     *
+     * The path trie is walked in preorder, so values sharing a dotted prefix are adjacent.
+     * The objects of the previous value stay open, only the nodes which are not ancestors of
+     * the next value are closed, and its missing ancestors are opened. Keys are the segments 
+     * of the nodes, the flags are never split.
+     */
+    void Config::writeJSON(Writer& out, bool pretty, size_t root)
+    {
+        // nodes of the open objects, below the root
+        std::vector<size_t> openNodes;
+        // whether the root (index 0) and each open object already contain a member
+        std::vector<bool> hasMembers(1, false);
+        // ancestors of the current node below the root, innermost first
+        std::vector<size_t> ancestors;
+
+        out.put('{');
+        sortNodes();
+        for (size_t node = root; node != NO_SLOT; node = nextNode(node, root)) {
+            size_t slot = _nodes[node].slot;
+            if (node == root || slot == NO_SLOT || !hasValue(slot) || _optionValues[slot].isEmpty()) {
+                continue;
+            }
+
+            ancestors.clear();
+            for (size_t parent = _nodes[node].parent; parent != root; parent = _nodes[parent].parent) {
+                ancestors.push_back(parent);
+            }
+
+            // number of open objects shared with the previous value
+            size_t common = 0;
+            while (common < openNodes.size() && common < ancestors.size() &&
+                    openNodes[common] == ancestors[ancestors.size() - 1 - common]) {
+                ++common;
+            }
+
+            // close the objects which are not shared
+            while (openNodes.size() > common) {
+                openNodes.pop_back();
+                hasMembers.pop_back();
+                if (pretty) {
+                    out.writeJSONIndent(openNodes.size() + 1);
+                }
+                out.put('}');
+            }
+
+            // open the objects of the remaining ancestors, and write the key of the value
+            for (size_t i = ancestors.size() - common; ; --i) {
+                const PathNode& current = _nodes[(i == 0) ? node : ancestors[i - 1]];
+                if (hasMembers.back()) {
+                    out.put(',');
+                }
+                hasMembers.back() = true;
+                if (pretty) {
+                    out.writeJSONIndent(openNodes.size() + 1);
+                }
+                out.writeJSONString(current.path + current.segment, current.length - current.segment);
+                out.put(':');
+                if (pretty) {
+                    out.put(' ');
+                }
+                if (i == 0) {
+                    break;
+                }
+                out.put('{');
+                openNodes.push_back(ancestors[i - 1]);
+                hasMembers.push_back(false);
+            }
+
+            writeJSONValue(out, _optionValues[slot], pretty, openNodes.size() + 1);
+        }
+
+        // close all objects
+        while (!openNodes.empty()) {
+            openNodes.pop_back();
+            hasMembers.pop_back();
+            if (pretty) {
+                out.writeJSONIndent(openNodes.size() + 1);
+            }
+            out.put('}');
+        }
+        if (pretty && hasMembers.back()) {
+            out.writeJSONIndent(0);
+        }
+        out.put('}');
+        if (pretty) {
+            out.put('\n');
+        }
+    }
+
+    // writes a value, numbers are formatted like picojson
+    void Config::writeJSONValue(Writer& out, const Value& value, bool pretty, size_t depth)
+    {
+        char number[256];
+        double integral;
+        switch (value.type()) {
+            case Value::DataType::INT:
+                snprintf(number, sizeof(number), "%d", value.getInt());
+                out.write(number);
+                break;
+            case Value::DataType::INT64:
+                snprintf(number, sizeof(number), "%lld", static_cast<long long>(value.getInt64()));
+                out.write(number);
+                break;
+            case Value::DataType::NUMBER:
+                // JSON has no representation of infinity and NaN, they are written as the strings
+                // read back by the loaders into number options
+                if (!std::isfinite(value.getNumber())) {
+                    out.write(std::isnan(value.getNumber()) ? "\"nan\"" : (value.getNumber() < 0 ? "\"-inf\"" : "\"inf\""));
+                    break;
+                }
+                snprintf(number, sizeof(number), 
+                         (fabs(value.getNumber()) < (1ULL << 53) && modf(value.getNumber(), &integral) == 0) ? "%.f" : "%.17g", 
+                         value.getNumber());
+                // the output must not depend on the decimal point of the locale
+                for (char* c = number; *c != '\0'; ++c) {
+                    if (*c == ',') {
+                        *c = '.';
+                    }
+                }
+                out.write(number);
+                break;
+            case Value::DataType::BOOL:
+                out.write(value.getBoolean() ? "true" : "false");
+                break;
+            case Value::DataType::STRING:
+                out.writeJSONString(value.getCharArray(), value.size());
+                break;
+            case Value::DataType::INT_ARRAY:
+            case Value::DataType::NUMBER_ARRAY:
+            case Value::DataType::BOOL_ARRAY:
+            case Value::DataType::STRING_ARRAY: {
+                // one element per line like picojson
+                std::vector<Value> elements;
+                splitArray(value, elements);
+                out.put('[');
+                for (size_t i = 0; i < elements.size(); ++i) {
+                    if (i != 0) {
+                        out.put(',');
+                    }
+                    if (pretty) {
+                        out.writeJSONIndent(depth + 1);
+                    }
+                    writeJSONValue(out, elements[i], pretty, depth + 1);
+                }
+                if (pretty && !elements.empty()) {
+                    out.writeJSONIndent(depth);
+                }
+                out.put(']');
+                break;
+            }
+            default:
+                break;
+        }
+    }
+#endif
+
+    /* Binary snapshot layout
+     *
+     * A snapshot is a header, followed by the checksums of the data blocks and the data: one
+     * fixed-width entry per slot, a hash index of the entries by flag, the entries loaded when
+     * the snapshot is attached, and a table of null-terminated strings. Every string is stored
+     * once and referenced by its offset. Integers are stored in the byte order of the writer,
+     * a snapshot written on a machine with a different byte order is rejected.
+     *
+     * A snapshot is read in place. The header checksum covers the header fields after the
+     * checksum and the block checksums, which are validated when the snapshot is opened. The
+     * data is checksummed in blocks of BINARY_BLOCK_SIZE bytes, a block is verified the first
+     * time it is read, so a lookup reads a few pages of the file however large it is. The
+     * sections and the file are padded to a multiple of 8 bytes.
+     */
+    static const char BINARY_MAGIC[8] = { 'M', 'I', 'N', 'I', 'C', 'O', 'N', 'F' };
+    static const uint32_t BINARY_VERSION = 1;
+    static const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+    static const size_t BINARY_BLOCK_SIZE = 4096;
+
+    // bits of BinaryEntry::attributes
+    enum BinaryAttribute {
+        BINARY_REQUIRED = 1,
+        BINARY_HIDDEN = 2
+    };
+
+    // the offsets are relative to the start of the file
+    struct BinaryHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint64_t fileSize;
+        uint64_t checksum;
+        uint32_t blockOffset;   // checksums of the data blocks, the data follows them
+        uint32_t blockCount;
+        uint32_t entryOffset;
+        uint32_t entryCount;
+        uint32_t indexOffset;   // hash index, a power of 2 buckets
+        uint32_t indexSize;
+        uint32_t pinnedOffset;  // entries loaded when the snapshot is attached
+        uint32_t pinnedCount;
+        uint32_t stringOffset;
+        uint32_t stringSize;
+    };
+
+    // a string in the string table
+    struct BinaryString {
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    /* a value, the payload holds the number, the boolean or the string offset
+     *
+     * The elements of an array are stored in the string table, the size is their size in 
+     * bytes: raw elements of a number array, or the null-terminated elements of a string array.
+     */
+    struct BinaryValue {
+        uint32_t type;
+        uint32_t size;
+        uint64_t payload;
+    };
+
+    struct BinaryEntry {
+        BinaryString flag;
+        BinaryString shortflag;
+        BinaryString description;
+        uint32_t state;         // SlotState bits of the slot
+        uint32_t attributes;    // BinaryAttribute bits of the option
+        BinaryValue defaultValue;
+        BinaryValue value;
+    };
+
+    // a bucket of the hash index, (index + 1) of an entry or 0 when empty, and the low 32 bits
+    // of the hash of its flag
+    struct BinaryBucket {
+        uint32_t entry;
+        uint32_t hash;
+    };
+
+    static_assert(sizeof(BinaryHeader) == 72, "unexpected padding in BinaryHeader");
+    static_assert(sizeof(BinaryEntry) == 64, "unexpected padding in BinaryEntry");
+    static_assert(sizeof(BinaryBucket) == 8, "unexpected padding in BinaryBucket");
+
+    // the header checksum covers the header fields after the checksum and the block checksums
+    static const size_t BINARY_CHECKSUM_BEGIN = offsetof(BinaryHeader, checksum) + sizeof(uint64_t);
+
+    // FNV-1a over 64-bit words, the size must be a multiple of 8
+    static uint64_t binaryChecksum(const char* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // FNV-1a hash of a flag in the hash index, unlike hashFlag() it does not depend on the width of size_t
+    static uint64_t binaryFlagHash(const char* flag, size_t length)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(flag[i])) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    /* string table of a snapshot under construction, identical strings are stored once
+     *
+     * The strings are found with an open-addressing hash index like the flags of the option
+     * store, a bucket stores (index + 1) of a string in _strings, or 0 when empty.
+     */
+    class BinaryStringTable
+    {
+        public:
+
+            // offset 0 is the empty string
+            BinaryStringTable() : _data(1, '\0') {}
+
+            BinaryString intern(const char* str, size_t size)
+            {
+                BinaryString result = { 0, static_cast<uint32_t>(size) };
+                if (size == 0) {
+                    return result;
+                }
+                size_t hash = hashFlag(str, size);
+                if (!_index.empty()) {
+                    size_t mask = _index.size() - 1;
+                    for (size_t bucket = hash & mask; _index[bucket] != 0; bucket = (bucket + 1) & mask) {
+                        const BinaryString& found = _strings[_index[bucket] - 1];
+                        if (found.size == size && memcmp(_data.data() + found.offset, str, size) == 0) {
+                            return found;
+                        }
+                    }
+                }
+
+                // keep the load factor of the hash index below 1/2
+                if ((_strings.size() + 1) * 2 > _index.size()) {
+                    std::vector<uint32_t> newIndex(_index.empty() ? 64 : _index.size() * 2, 0);
+                    for (size_t i = 0; i < _strings.size(); ++i) {
+                        insert(newIndex, _hashes[i], static_cast<uint32_t>(i + 1));
+                    }
+                    _index.swap(newIndex);
+                }
+                result.offset = static_cast<uint32_t>(_data.size());
+                _data.append(str, size);
+                _data.push_back('\0');
+                _strings.push_back(result);
+                _hashes.push_back(hash);
+                insert(_index, hash, static_cast<uint32_t>(_strings.size()));
+                return result;
+            }
+
+            BinaryString intern(const std::string& str) { return intern(str.data(), str.size()); }
+
+            const std::string& data() const { return _data; }
+
+        private:
+
+            static void insert(std::vector<uint32_t>& index, size_t hash, uint32_t entry)
+            {
+                size_t mask = index.size() - 1;
+                size_t bucket = hash & mask;
+                while (index[bucket] != 0) {
+                    bucket = (bucket + 1) & mask;
+                }
+                index[bucket] = entry;
+            }
+
+            std::string _data;
+            std::vector<BinaryString> _strings;
+            std::vector<size_t> _hashes;
+            std::vector<uint32_t> _index;
+    };
+
+    static BinaryValue packBinaryValue(Value& value, BinaryStringTable& strings)
+    {
+        BinaryValue packed = { static_cast<uint32_t>(value.type()), 0, 0 };
+        switch (value.type()) {
+            case Value::DataType::INT:
+                packed.payload = static_cast<uint64_t>(static_cast<int64_t>(value.getInt()));
+                break;
+            case Value::DataType::INT64:
+                packed.payload = static_cast<uint64_t>(value.getInt64());
+                break;
+            case Value::DataType::NUMBER: {
+                double number = value.getNumber();
+                memcpy(&packed.payload, &number, sizeof(number));
+                break;
+            }
+            case Value::DataType::BOOL:
+                packed.payload = value.getBoolean() ? 1 : 0;
+                break;
+            case Value::DataType::STRING: {
+                BinaryString str = strings.intern(value.getCharArray(), value.size());
+                packed.size = str.size;
+                packed.payload = str.offset;
+                break;
+            }
+            case Value::DataType::INT_ARRAY:
+            case Value::DataType::NUMBER_ARRAY:
+            case Value::DataType::BOOL_ARRAY:
+            case Value::DataType::STRING_ARRAY: {
+                std::string elements;
+                if (value.type() == Value::DataType::INT_ARRAY) {
+                    elements.assign(reinterpret_cast<const char*>(value.getIntArray().data()), value.size() * sizeof(int));
+                } else if (value.type() == Value::DataType::NUMBER_ARRAY) {
+                    elements.assign(reinterpret_cast<const char*>(value.getNumberArray().data()), value.size() * sizeof(double));
+                } else if (value.type() == Value::DataType::BOOL_ARRAY) {
+                    for (bool item : value.getBooleanArray()) {
+                        elements.push_back(item ? 1 : 0);
+                    }
+                } else {
+                    for (const char* item : value.getStringArray()) {
+                        elements.append(item);
+                        elements.push_back('\0');
+                    }
+                }
+                BinaryString str = strings.intern(elements);
+                packed.size = str.size;
+                packed.payload = str.offset;
+                break;
+            }
+            default:
+                break;
+        }
+        return packed;
+    }
+
+    // checks that a string lies within the string table and is null-terminated
+    static bool validBinaryString(uint64_t offset, uint64_t size, const char* strings, uint32_t stringSize)
+    {
+        return offset < stringSize && size < stringSize - offset && strings[offset + size] == '\0';
+    }
+
+    static bool validBinaryValue(const BinaryValue& value, const char* strings, uint32_t stringSize)
+    {
+        Value::DataType type = static_cast<Value::DataType>(value.type);
+        if (value.type > static_cast<uint32_t>(Value::DataType::STRING_ARRAY)) {
+            return false;
+        }
+        if (type != Value::DataType::STRING && Value::elementType(type) == Value::DataType::UNKNOWN) {
+            return true;
+        }
+        if (!validBinaryString(value.payload, value.size, strings, stringSize)) {
+            return false;
+        }
+        switch (type) {
+            case Value::DataType::INT_ARRAY:
+                return value.size % sizeof(int) == 0;
+            case Value::DataType::NUMBER_ARRAY:
+                return value.size % sizeof(double) == 0;
+            case Value::DataType::STRING_ARRAY:
+                return value.size == 0 || strings[value.payload + value.size - 1] == '\0';
+            default:
+                return true;
+        }
+    }
+
+    static Value unpackBinaryValue(const BinaryValue& value, const char* strings)
+    {
+        switch (static_cast<Value::DataType>(value.type)) {
+            case Value::DataType::INT:
+                return Value(static_cast<int>(static_cast<int64_t>(value.payload)));
+            case Value::DataType::INT64:
+                return Value(static_cast<int64_t>(value.payload));
+            case Value::DataType::NUMBER: {
+                double number;
+                memcpy(&number, &value.payload, sizeof(number));
+                return Value(number);
+            }
+            case Value::DataType::BOOL:
+                return Value(value.payload != 0);
+            case Value::DataType::STRING:
+                return Value(strings + value.payload, value.size);
+            case Value::DataType::INT_ARRAY: {
+                std::vector<int> items(value.size / sizeof(int));
+                if (!items.empty()) {
+                    memcpy(items.data(), strings + value.payload, value.size);
+                }
+                return Value(items);
+            }
+            case Value::DataType::NUMBER_ARRAY: {
+                std::vector<double> items(value.size / sizeof(double));
+                if (!items.empty()) {
+                    memcpy(items.data(), strings + value.payload, value.size);
+                }
+                return Value(items);
+            }
+            case Value::DataType::BOOL_ARRAY: {
+                std::vector<bool> items;
+                for (uint32_t i = 0; i < value.size; ++i) {
+                    items.push_back(strings[value.payload + i] != 0);
+                }
+                return Value(items);
+            }
+            case Value::DataType::STRING_ARRAY: {
+                std::vector<std::string> items;
+                for (const char* item = strings + value.payload; item < strings + value.payload + value.size; item += strlen(item) + 1) {
+                    items.push_back(item);
+                }
+                return Value(items);
+            }
+            default:
+                return Value();
+        }
+    }
+
+    /* reader of a binary snapshot in memory, the entries are read in place
+     *
+     * open() validates the header and the block checksums only. A block of the data is
+     * verified the first time an entry, a bucket or a string within it is read; a corrupt
+     * block is logged once, and the entries referring to it are treated as missing.
+     */
+    class Config::BinaryReader
+    {
+        public:
+
+            BinaryReader() : _config(nullptr), _data(nullptr), _size(0), _dataOffset(0) {}
+
+            // validates the header of a snapshot, the snapshot must outlive the reader
+            bool open(Config* config, const std::string& name, const char* data, size_t size)
+            {
+                _config = config;
+                _name = name;
+                if (size < sizeof(_header)) {
+                    _config->log(LogLevel::WARNING, _name, "Unable to load binary snapshot, the file is truncated");
+                    return false;
+                }
+                memcpy(&_header, data, sizeof(_header));
+                if (_header.version != BINARY_VERSION || _header.byteOrder != BINARY_BYTE_ORDER) {
+                    _config->log(LogLevel::WARNING, _name, "Unable to load binary snapshot, unsupported version or byte order");
+                    return false;
+                }
+                _data = data;
+                _size = size;
+                _dataOffset = static_cast<uint64_t>(_header.blockOffset) + static_cast<uint64_t>(_header.blockCount) * sizeof(uint64_t);
+                if (_header.fileSize != size || size % sizeof(uint64_t) != 0
+                    || _header.blockOffset != sizeof(_header) || _dataOffset > size
+                    || _header.blockCount != (size - _dataOffset + BINARY_BLOCK_SIZE - 1) / BINARY_BLOCK_SIZE
+                    || !contains(_header.entryOffset, static_cast<uint64_t>(_header.entryCount) * sizeof(BinaryEntry))
+                    || !contains(_header.indexOffset, static_cast<uint64_t>(_header.indexSize) * sizeof(BinaryBucket))
+                    || _header.indexSize <= _header.entryCount || (_header.indexSize & (_header.indexSize - 1)) != 0
+                    || !contains(_header.pinnedOffset, static_cast<uint64_t>(_header.pinnedCount) * sizeof(uint32_t))
+                    || !contains(_header.stringOffset, _header.stringSize) || _header.stringSize == 0) {
+                    _config->log(LogLevel::WARNING, _name, "Unable to load binary snapshot, the header is invalid");
+                    return false;
+                }
+                if (binaryChecksum(data + BINARY_CHECKSUM_BEGIN, static_cast<size_t>(_dataOffset) - BINARY_CHECKSUM_BEGIN) != _header.checksum) {
+                    _config->log(LogLevel::WARNING, _name, "Unable to load binary snapshot, checksum mismatch");
+                    return false;
+                }
+                _blocks.assign(_header.blockCount, BLOCK_UNCHECKED);
+                return true;
+            }
+
+            // gets the number of entries
+            size_t count() const { return _header.entryCount; }
+
+            // gets the number of entries loaded when the snapshot is attached
+            size_t pinnedCount() const { return _header.pinnedCount; }
+
+            // gets an entry loaded when the snapshot is attached, NO_SLOT if it cannot be read
+            size_t pinned(size_t i)
+            {
+                uint64_t offset = _header.pinnedOffset + i * sizeof(uint32_t);
+                uint32_t entry;
+                if (!verify(offset, sizeof(entry))) {
+                    return NO_SLOT;
+                }
+                memcpy(&entry, _data + offset, sizeof(entry));
+                return (entry < _header.entryCount) ? entry : NO_SLOT;
+            }
+
+            // finds the entry of a flag, NO_SLOT if not found
+            size_t find(const char* flag, size_t length, uint64_t hash)
+            {
+                size_t mask = _header.indexSize - 1;
+                for (size_t bucket = hash & mask, probes = 0; probes < _header.indexSize; bucket = (bucket + 1) & mask, ++probes) {
+                    uint64_t offset = _header.indexOffset + bucket * sizeof(BinaryBucket);
+                    BinaryBucket item;
+                    if (!verify(offset, sizeof(item))) {
+                        return NO_SLOT;
+                    }
+                    memcpy(&item, _data + offset, sizeof(item));
+                    if (item.entry == 0) {
+                        return NO_SLOT;
+                    }
+                    const char* entryFlag;
+                    size_t entryLength;
+                    if (item.hash == static_cast<uint32_t>(hash) && this->flag(item.entry - 1, entryFlag, entryLength)
+                        && entryLength == length && memcmp(entryFlag, flag, length) == 0) {
+                        return item.entry - 1;
+                    }
+                }
+                return NO_SLOT;
+            }
+
+            // gets the flag of an entry, false if the entry cannot be read
+            bool flag(size_t index, const char*& flag, size_t& length)
+            {
+                BinaryEntry entry;
+                if (!record(index, entry) || !validString(entry.flag.offset, entry.flag.size)) {
+                    return false;
+                }
+                flag = strings() + entry.flag.offset;
+                length = entry.flag.size;
+                return true;
+            }
+
+            // reads an entry, the strings and values it refers to are verified
+            bool entry(size_t index, BinaryEntry& entry)
+            {
+                return record(index, entry) && validString(entry.flag.offset, entry.flag.size)
+                    && validString(entry.shortflag.offset, entry.shortflag.size)
+                    && validString(entry.description.offset, entry.description.size)
+                    && validValue(entry.defaultValue) && validValue(entry.value);
+            }
+
+            // gets the string table
+            const char* strings() const { return _data + _header.stringOffset; }
+
+        private:
+
+            enum BlockState {
+                BLOCK_UNCHECKED,
+                BLOCK_VALID,
+                BLOCK_CORRUPT
+            };
+
+            // checks that a range lies within the data
+            bool contains(uint64_t offset, uint64_t size) const
+            {
+                return offset >= _dataOffset && offset <= _size && size <= _size - offset;
+            }
+
+            // verifies the blocks overlapping a range of the data, which has been checked to lie within the data
+            bool verify(uint64_t offset, uint64_t size)
+            {
+                size_t last = static_cast<size_t>((offset + size - 1 - _dataOffset) / BINARY_BLOCK_SIZE);
+                for (size_t block = static_cast<size_t>((offset - _dataOffset) / BINARY_BLOCK_SIZE); block <= last; ++block) {
+                    if (_blocks[block] == BLOCK_UNCHECKED) {
+                        size_t begin = static_cast<size_t>(_dataOffset) + block * BINARY_BLOCK_SIZE;
+                        uint64_t checksum;
+                        memcpy(&checksum, _data + _header.blockOffset + block * sizeof(checksum), sizeof(checksum));
+                        if (binaryChecksum(_data + begin, std::min(BINARY_BLOCK_SIZE, _size - begin)) == checksum) {
+                            _blocks[block] = BLOCK_VALID;
+                        } else {
+                            _blocks[block] = BLOCK_CORRUPT;
+                            _config->log(LogLevel::WARNING, _name, "checksum mismatch in binary snapshot, the entries in the corrupt block are not loaded");
+                        }
+                    }
+                    if (_blocks[block] != BLOCK_VALID) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // reads an entry without verifying what it refers to
+            bool record(size_t index, BinaryEntry& entry)
+            {
+                uint64_t offset = _header.entryOffset + index * sizeof(BinaryEntry);
+                if (index >= _header.entryCount || !verify(offset, sizeof(entry))) {
+                    return false;
+                }
+                memcpy(&entry, _data + offset, sizeof(entry));
+                return true;
+            }
+
+            bool validString(uint64_t offset, uint64_t size)
+            {
+                return offset < _header.stringSize && size < _header.stringSize - offset
+                    && verify(_header.stringOffset + offset, size + 1)
+                    && validBinaryString(offset, size, strings(), _header.stringSize);
+            }
+
+            bool validValue(const BinaryValue& value)
+            {
+                // strings and arrays refer to the string table
+                Value::DataType type = static_cast<Value::DataType>(value.type);
+                bool referenced = value.type <= static_cast<uint32_t>(Value::DataType::STRING_ARRAY)
+                    && (type == Value::DataType::STRING || Value::elementType(type) != Value::DataType::UNKNOWN);
+                return (!referenced || validString(value.payload, value.size)) && validBinaryValue(value, strings(), _header.stringSize);
+            }
+
+            // the Config object logging the corrupt blocks, and the path of the snapshot
+            Config* _config;
+            std::string _name;
+
+            const char* _data;
+            size_t _size;
+            BinaryHeader _header;
+
+            // offset of the first data block
+            uint64_t _dataOffset;
+
+            // block -> BlockState
+            std::vector<unsigned char> _blocks;
+    };
+
+    void Config::writeBinary(Writer& out)
+    {
+        BinaryStringTable strings;
+        std::vector<BinaryEntry> entries;
+        std::vector<uint64_t> hashes;
+        std::vector<uint32_t> pinned;
+        for (size_t slot : sortedSlots()) {
+            if (_slotStates[slot] == 0) {
+                continue;
+            }
+            BinaryEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.flag = strings.intern(_flags[slot]);
+            entry.state = _slotStates[slot] & (SLOT_OPTION | SLOT_VALUE);
+            if (hasOption(slot)) {
+                Option& option = _options[slot];
+                entry.shortflag = strings.intern(option._shortflag);
+                entry.description = strings.intern(option._description);
+                entry.attributes = (option._required ? BINARY_REQUIRED : 0) | (option._hidden ? BINARY_HIDDEN : 0);
+                entry.defaultValue = packBinaryValue(option._defaultValue, strings);
+                // validate() removes the values of hidden options and reports the options without
+                // a value, these entries are loaded when the snapshot is attached
+                if (option._hidden || !hasValue(slot)) {
+                    pinned.push_back(static_cast<uint32_t>(entries.size()));
+                }
+            }
+            if (hasValue(slot)) {
+                entry.value = packBinaryValue(_optionValues[slot], strings);
+            }
+            entries.push_back(entry);
+            hashes.push_back(binaryFlagHash(_flags[slot].data(), _flags[slot].size()));
+        }
+
+        // hash index of the entries, the load factor is kept below 1/2 like the slot index
+        size_t buckets = 16;
+        while (buckets < entries.size() * 2) {
+            buckets *= 2;
+        }
+        std::vector<BinaryBucket> index(buckets);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            size_t bucket = hashes[i] & (buckets - 1);
+            while (index[bucket].entry != 0) {
+                bucket = (bucket + 1) & (buckets - 1);
+            }
+            index[bucket].entry = static_cast<uint32_t>(i + 1);
+            index[bucket].hash = static_cast<uint32_t>(hashes[i]);
+        }
+        size_t pinnedCount = pinned.size();
+        pinned.resize((pinnedCount + 1) / 2 * 2, 0);
+
+        // assemble the data, then checksum its blocks and the header
+        BinaryHeader header;
+        memset(&header, 0, sizeof(header));
+        size_t entrySize = entries.size() * sizeof(BinaryEntry);
+        size_t indexSize = buckets * sizeof(BinaryBucket);
+        size_t pinnedSize = pinned.size() * sizeof(uint32_t);
+        size_t stringSize = strings.data().size();
+        size_t padding = (sizeof(uint64_t) - stringSize % sizeof(uint64_t)) % sizeof(uint64_t);
+        size_t dataSize = entrySize + indexSize + pinnedSize + stringSize + padding;
+        size_t blockCount = (dataSize + BINARY_BLOCK_SIZE - 1) / BINARY_BLOCK_SIZE;
+        size_t dataOffset = sizeof(header) + blockCount * sizeof(uint64_t);
+        memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+        header.version = BINARY_VERSION;
+        header.byteOrder = BINARY_BYTE_ORDER;
+        header.fileSize = dataOffset + dataSize;
+        header.blockOffset = static_cast<uint32_t>(sizeof(header));
+        header.blockCount = static_cast<uint32_t>(blockCount);
+        header.entryOffset = static_cast<uint32_t>(dataOffset);
+        header.entryCount = static_cast<uint32_t>(entries.size());
+        header.indexOffset = static_cast<uint32_t>(dataOffset + entrySize);
+        header.indexSize = static_cast<uint32_t>(buckets);
+        header.pinnedOffset = static_cast<uint32_t>(dataOffset + entrySize + indexSize);
+        header.pinnedCount = static_cast<uint32_t>(pinnedCount);
+        header.stringOffset = static_cast<uint32_t>(dataOffset + entrySize + indexSize + pinnedSize);
+        header.stringSize = static_cast<uint32_t>(stringSize);
+
+        std::string image;
+        image.reserve(static_cast<size_t>(header.fileSize));
+        image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        image.append(blockCount * sizeof(uint64_t), '\0');
+        if (!entries.empty()) {
+            image.append(reinterpret_cast<const char*>(entries.data()), entrySize);
+        }
+        image.append(reinterpret_cast<const char*>(index.data()), indexSize);
+        if (!pinned.empty()) {
+            image.append(reinterpret_cast<const char*>(pinned.data()), pinnedSize);
+        }
+        image.append(strings.data());
+        image.append(padding, '\0');
+        for (size_t block = 0; block < blockCount; ++block) {
+            size_t begin = dataOffset + block * BINARY_BLOCK_SIZE;
+            uint64_t checksum = binaryChecksum(image.data() + begin, std::min(BINARY_BLOCK_SIZE, image.size() - begin));
+            memcpy(&image[sizeof(header) + block * sizeof(checksum)], &checksum, sizeof(checksum));
+        }
+        header.checksum = binaryChecksum(image.data() + BINARY_CHECKSUM_BEGIN, dataOffset - BINARY_CHECKSUM_BEGIN);
+        memcpy(&image[offsetof(BinaryHeader, checksum)], &header.checksum, sizeof(header.checksum));
+        out.write(image.data(), image.size());
+    }
+
+    bool Config::loadBinary(Layer& values, const char* binaryData, size_t size)
+    {
+        BinaryReader reader;
+        if (!reader.open(this, "", binaryData, size)) {
+            values.malformed = true;
+            return false;
+        }
+        bool success = true;
+        for (size_t entry = 0; entry < reader.count(); ++entry) {
+            size_t slot;
+            Value value;
+            if (!loadBinaryEntry(reader, entry, slot, value)) {
+                success = false;
+            } else if (value.type() != Value::DataType::UNKNOWN) {
+                values.assign(slot) = std::move(value);
+            }
+        }
+        return success;
+    }
+
+    bool Config::loadBinaryEntry(BinaryReader& reader, size_t index, size_t& slot, Value& value)
+    {
+        BinaryEntry entry;
+        if (!reader.entry(index, entry)) {
+            return false;
+        }
+        const char* strings = reader.strings();
+        slot = acquireSlot(strings + entry.flag.offset, entry.flag.size);
+
+        // options defined by the program take precedence over the schema in the snapshot
+        if ((entry.state & SLOT_OPTION) && !hasOption(slot)) {
+            option(_flags[slot])
+                .shortflag(std::string(strings + entry.shortflag.offset, entry.shortflag.size))
+                .description(std::string(strings + entry.description.offset, entry.description.size))
+                .defaultValue(unpackBinaryValue(entry.defaultValue, strings))
+                .required((entry.attributes & BINARY_REQUIRED) != 0)
+                .hidden((entry.attributes & BINARY_HIDDEN) != 0);
+        }
+        if (!(entry.state & SLOT_VALUE)) {
+            return true;
+        }
+        value = unpackBinaryValue(entry.value, strings);
+        if (hasOption(slot) && _options[slot].type() != Value::DataType::UNKNOWN && _options[slot].type() != value.type()) {
+            log(LogLevel::WARNING, _flags[slot].c_str(), "value in snapshot does not match the option type, it is not loaded");
+            value = Value::unknown();
+            return false;
+        }
+        log(LogLevel::INFO, _flags[slot].c_str(), "value is loaded from snapshot");
+        return true;
+    }
+
+    void Config::writeFormat(Writer& out, ExportFormat format, bool pretty)
+    {
+        loadMappedEntries();
+        switch (format) {
+#ifdef MINICONF_JSON_SUPPORT
+            case ExportFormat::JSON:
+                writeJSON(out, pretty);
+                break;
+#endif
+            case ExportFormat::CSV:
+                writeCSV(out);
+                break;
+            case ExportFormat::BINARY:
+                writeBinary(out);
+                break;
+        }
+    }
+
+    std::string Config::serialize(const std::string& serializeFilePath, ExportFormat format, bool pretty)
+    {
+        std::string outStr;
+
+        // extract extension
+        std::string extension = "";
+        size_t lastDot = serializeFilePath.find_last_of(".");
+        if (lastDot != std::string::npos) {
+            extension = serializeFilePath.substr(lastDot + 1);
+        }
+#ifdef MINICONF_JSON_SUPPORT
+        if (extension == "json" || extension == "JSON"){
+            format = ExportFormat::JSON;
+        } else if (extension == "csv" || extension == "CSV"){
+            format = ExportFormat::CSV;
+        } else if (extension == "bin" || extension == "BIN"){
+            format = ExportFormat::BINARY;
+        } else {
+            format = ExportFormat::CSV;
+        }
+#else
+        if (extension == "bin" || extension == "BIN"){
+            format = ExportFormat::BINARY;
+        } else {
+            format = ExportFormat::CSV;
+        }
+#endif
+
+        if (serializeFilePath.empty()) {
+            Writer out(&outStr);
+            writeFormat(out, format, pretty);
+            return outStr;
+        }
+
+        // the file may be an attached snapshot, which is unmapped before it is truncated
+        loadMappedEntries();
+
+        // stream to the file, it is buffered by the writer already
+        FILE* fd = fopen(serializeFilePath.c_str(), "wb");
+        if (fd == nullptr) {
+            log(LogLevel::WARNING, serializeFilePath.c_str(), "unable to open file for writing");
+            return outStr;
+        }
+        setvbuf(fd, nullptr, _IONBF, 0);
+        bool success = serialize(fd, format, pretty);
+        success = (fclose(fd) == 0) && success;
+        if (!success) {
+            log(LogLevel::WARNING, serializeFilePath.c_str(), "unable to write file");
+        }
+        return outStr;
+    }
+
+    bool Config::serialize(FILE* fd, ExportFormat format, bool pretty)
+    {
+        Writer out(fd);
+        writeFormat(out, format, pretty);
+        return out.flush();
+    }
+
+    std::string Config::serializeSection(const std::string& section, ExportFormat format, bool pretty)
+    {
+        std::string outStr;
+        loadMappedEntries();
+        size_t root = findNode(section);
+        if (format == ExportFormat::BINARY) {
+            log(LogLevel::WARNING, section, "binary snapshots cannot be written for a section");
+            return outStr;
+        }
+        Writer out(&outStr);
+        if (root == NO_SLOT) {
+            // an unknown section is empty
+#ifdef MINICONF_JSON_SUPPORT
+            if (format == ExportFormat::JSON) {
+                out.write(pretty ? "{}\n" : "{}");
+            }
+#endif
+        } else {
+#ifdef MINICONF_JSON_SUPPORT
+            if (format == ExportFormat::JSON) {
+                writeJSON(out, pretty, root);
+            } else {
+                writeCSV(out, root);
+            }
+#else
+            writeCSV(out, root);
+#endif
+        }
+        out.flush();
+        return outStr;
+    }
+
+    bool Config::loadSection(const std::string& section, const std::string& content, ExportFormat format)
+    {
+        if (format == ExportFormat::BINARY) {
+            log(LogLevel::WARNING, section, "binary snapshots cannot be loaded into a section");
+            return false;
+        }
+        Layer values;
+#ifdef MINICONF_JSON_SUPPORT
+        bool success = (format == ExportFormat::JSON) ?
+                loadJSON(values, content.data(), content.size(), section) : 
+                loadCSV(values, content.data(), content.size(), section);
+#else
+        bool success = loadCSV(values, content.data(), content.size(), section);
+#endif
+        if (values.malformed) {
+            return false;
+        }
+        beginBatch();
+        mergeLayer(acquireLayer(Source::OVERRIDE, layerName(Source::OVERRIDE)), values);
+        endBatch();
+        return success;
+    }
+
+    bool Config::snapshot(const std::string& snapshotFilePath, ExportFormat format, bool pretty)
+    {
+        if (snapshotFilePath.empty()) {
+            return false;
+        }
+#ifdef MINICONF_FSYNC_SUPPORT
+        // the temporary file must be on the same file system for rename() to be atomic
+        std::vector<char> tempPath(snapshotFilePath.begin(), snapshotFilePath.end());
+        const char suffix[] = ".XXXXXX";
+        tempPath.insert(tempPath.end(), suffix, suffix + sizeof(suffix));
+        int fd = mkstemp(tempPath.data());
+        if (fd < 0) {
+            log(LogLevel::WARNING, snapshotFilePath.c_str(), "unable to create snapshot file");
+            return false;
+        }
+        struct stat st;
+        mode_t mode = (stat(snapshotFilePath.c_str(), &st) == 0) ? (st.st_mode & 07777) : 0644;
+        FILE* file = fdopen(fd, "wb");
+        bool success = (file != nullptr) && fchmod(fd, mode) == 0 && serialize(file, format, pretty);
+        success = success && fsync(fd) == 0;
+        if (file != nullptr) {
+            success = (fclose(file) == 0) && success;
+        } else {
+            close(fd);
+        }
+        success = success && rename(tempPath.data(), snapshotFilePath.c_str()) == 0;
+        if (!success) {
+            unlink(tempPath.data());
+            log(LogLevel::WARNING, snapshotFilePath.c_str(), "unable to write snapshot file");
+            return false;
+        }
+
+        // the rename itself is only durable once the directory entry is on disk; EINVAL means
+        // the file system does not support syncing a directory, which is all it can do then
+        std::vector<char> dirPath(snapshotFilePath.begin(), snapshotFilePath.end());
+        dirPath.push_back('\0');
+        int dirFd = open(dirname(dirPath.data()), O_RDONLY);
+        bool synced = dirFd >= 0 && (fsync(dirFd) == 0 || errno == EINVAL);
+        if (dirFd >= 0) {
+            close(dirFd);
+        }
+        if (!synced) {
+            log(LogLevel::WARNING, snapshotFilePath.c_str(), "unable to sync the directory of the snapshot file");
+            return false;
+        }
+        return true;
+#else
+        // without fsync the temporary file still protects against truncated writes
+        std::string tempPath = snapshotFilePath + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        bool success = (file != nullptr) && serialize(file, format, pretty);
+#if defined(_WIN32)
+        success = success && _commit(_fileno(file)) == 0;
+#endif
+        if (file != nullptr) {
+            success = (fclose(file) == 0) && success;
+        }
+#if defined(_WIN32)
+        // rename() fails if the target exists, MoveFileExA() replaces it in a single step
+        success = success && MoveFileExA(tempPath.c_str(), snapshotFilePath.c_str(),
+                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        success = success && std::rename(tempPath.c_str(), snapshotFilePath.c_str()) == 0;
+#endif
+        if (!success) {
+            // qualified, Config::remove() removes an option
+            std::remove(tempPath.c_str());
+            log(LogLevel::WARNING, snapshotFilePath.c_str(), "unable to write snapshot file");
+        }
+        return success;
+#endif
+    }
+
+    /* Content of a config file
+     *
+     * Regular files are memory mapped so the parsers run directly over the mapped pages,
+     * anything else (pipes, character devices, files in /proc which report a zero size) is
+     * read into a buffer in large chunks.
+     */
+    class ConfigFile
+    {
+        public:
+
+            ConfigFile() : _mapped(nullptr), _size(0) {}
+
+            ~ConfigFile()
+            {
+#ifdef MINICONF_MMAP_SUPPORT
+                if (_mapped != nullptr) {
+                    munmap(_mapped, _size);
+                }
+#endif
+            }
+
+            // opens and maps / reads a file, returns false if the file cannot be read
+            bool open(const std::string& path)
+            {
+#ifdef MINICONF_MMAP_SUPPORT
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    return false;
+                }
+                struct stat status;
+                if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+                    void* mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped != MAP_FAILED) {
+                        madvise(mapped, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+                        _mapped = mapped;
+                        _size = static_cast<size_t>(status.st_size);
+                        close(fd);
+                        return true;
+                    }
+                }
+                const size_t chunkSize = 1 << 16;
+                bool success = true;
+                while (true) {
+                    size_t used = _buffer.size();
+                    _buffer.resize(used + chunkSize);
+                    ssize_t count = read(fd, &_buffer[used], chunkSize);
+                    if (count < 0 && errno == EINTR) {
+                        _buffer.resize(used);
+                        continue;
+                    }
+                    _buffer.resize(used + (count > 0 ? static_cast<size_t>(count) : 0));
+                    if (count <= 0) {
+                        success = (count == 0);
+                        break;
+                    }
+                }
+                close(fd);
+                _size = _buffer.size();
+                return success;
+#else
+                std::ifstream ifd(path, std::ios::in | std::ios::binary);
+                if (!ifd) {
+                    return false;
+                }
+                const size_t chunkSize = 1 << 16;
+                while (ifd) {
+                    size_t used = _buffer.size();
+                    _buffer.resize(used + chunkSize);
+                    ifd.read(&_buffer[used], chunkSize);
+                    _buffer.resize(used + static_cast<size_t>(ifd.gcount()));
+                }
+                _size = _buffer.size();
+                return true;
+#endif
+            }
+
+            // gets the content of the file
+            const char* data() const { return (_mapped != nullptr) ? static_cast<const char*>(_mapped) : _buffer.data(); }
+
+            // gets the size of the file content
+            size_t size() const { return _size; }
+
+            // checks if the file is memory mapped
+            bool mapped() const { return _mapped != nullptr; }
+
+            // hints that the content is read at random offsets rather than from start to end
+            void randomAccess()
+            {
+#ifdef MINICONF_MMAP_SUPPORT
+                if (_mapped != nullptr) {
+                    madvise(_mapped, _size, MADV_RANDOM);
+                }
+#endif
+            }
+
+            // exchanges the content with another file
+            void swap(ConfigFile& other)
+            {
+                std::swap(_mapped, other._mapped);
+                std::swap(_size, other._size);
+                _buffer.swap(other._buffer);
+            }
+
+        private:
+
+            ConfigFile(const ConfigFile&);
+            ConfigFile& operator=(const ConfigFile&);
+
+            // mapped pages of a regular file, or nullptr
+            void* _mapped;
+
+            // size of the content
+            size_t _size;
+
+            // content read from a non-mappable file
+            std::string _buffer;
+    };
+
+    // a binary snapshot attached to the layer of its file, the file stays mapped until it is detached
+    struct Config::MappedSnapshot {
+        ConfigFile file;
+        BinaryReader reader;
+        size_t layer;
+
+        MappedSnapshot() : layer(NO_SLOT) {}
+    };
+
+    bool Config::config(const std::string& configPath)
+    {
+#ifdef MINICONF_DIRECTORY_SUPPORT
+        struct stat status;
+        if (stat(configPath.c_str(), &status) == 0 && S_ISDIR(status.st_mode)) {
+            return configDirectory(configPath);
+        }
+#endif
+        _configPath = configPath;
+
+        // read content of the file
+        ConfigFile file;
+        if (!file.open(configPath)) {
+            log(LogLevel::WARNING, configPath, "unable to read config file");
+            return false;
+        }
+        log(LogLevel::INFO, configPath.c_str(), file.mapped() ? "config file is memory mapped" : "config file is read into a buffer");
+
+        // binary snapshots stay mapped, their entries are loaded when they are looked up
+        if (file.size() >= sizeof(BINARY_MAGIC) && memcmp(file.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+            std::unique_ptr<MappedSnapshot> mapped(new MappedSnapshot());
+            mapped->file.swap(file);
+            return attachBinary(configPath, mapped);
+        }
+
+        // the file replaces its own layer, the values of the other sources are not touched;
+        // a file which cannot be parsed leaves the layer as it was, like a failed reload in
+        // poll(), the values which are rejected are skipped and the others are loaded
+        Layer values;
+        bool success = load(values, configPath, file.data(), file.size());
+        if (values.malformed) {
+            log(LogLevel::WARNING, configPath, "unable to load config file, values are unchanged");
+            return false;
+        }
+        size_t layer = acquireLayer(Source::FILE, configPath);
+        detachBinary(layer);
+        beginBatch();
+        replaceLayer(layer, values);
+        endBatch();
+        return success;
+    }
+
+    bool Config::load(Layer& values, const std::string& configPath, const char* data, size_t size)
+    {
+        // binary snapshots are recognized by their magic bytes
+        if (size >= sizeof(BINARY_MAGIC) && memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+            return loadBinary(values, data, size);
+        }
+
+        // extract extension
+        std::string extension = "";
+        size_t lastDot = configPath.find_last_of(".");
+        if (lastDot != std::string::npos) {
+            extension = configPath.substr(lastDot + 1);
+        }
+
+        // load config according to extension
+        // default is json
+#ifdef MINICONF_JSON_SUPPORT
+        if (extension == "json" || extension == "JSON") {
+            return loadJSON(values, data, size);
+        } else if (extension == "csv" || extension == "CSV") {
+            return loadCSV(values, data, size);
+        } else {
+            return loadJSON(values, data, size);
+        }
+#else
+        return loadCSV(values, data, size);
+#endif
+
+        return false;
+    }
+
+    // the values of a fragment are numbered by its own slot table, the option types are read
+    // from the slot store of the Config
+    struct Config::DirectoryFragment {
+        std::string path;
+        SlotTable slotTable;
+        Layer values;
+        bool binary;        // binary snapshots are loaded when the fragments are merged
+        bool success;
+
+        DirectoryFragment() : binary(false), success(true)
+        {
+            values.slotTable = &slotTable;
+        }
+    };
+
+    bool Config::configDirectory(const std::string& directoryPath, unsigned threads)
+    {
+#ifdef MINICONF_DIRECTORY_SUPPORT
+        // the workers read the options of this object, which must not add slots meanwhile
+        loadMappedEntries();
+
+        // collect the config files by their extension, hidden files and backups are skipped
+        std::vector<std::string> names;
+        DIR* directory = opendir(directoryPath.c_str());
+        if (directory == nullptr) {
+            log(LogLevel::WARNING, directoryPath, "unable to read config directory");
+            return false;
+        }
+        for (struct dirent* entry = readdir(directory); entry != nullptr; entry = readdir(directory)) {
+            const char* name = entry->d_name;
+            const char* extension = strrchr(name, '.');
+            if (name[0] == '.' || extension == nullptr) {
+                continue;
+            }
+            const char* extensionEnd = extension + strlen(extension);
+#ifdef MINICONF_JSON_SUPPORT
+            if (equalsIgnoreCase(extension, extensionEnd, ".json")) {
+                names.push_back(name);
+                continue;
+            }
+#endif
+            if (equalsIgnoreCase(extension, extensionEnd, ".csv") || equalsIgnoreCase(extension, extensionEnd, ".bin")) {
+                names.push_back(name);
+            }
+        }
+        closedir(directory);
+
+        // the files are merged in the order of their names, so the result does not depend on the
+        // order in which they are parsed
+        std::sort(names.begin(), names.end());
+        std::string separator = (!directoryPath.empty() && directoryPath.back() != '/') ? "/" : "";
+        std::deque<DirectoryFragment> fragments;
+        for (const std::string& name : names) {
+            fragments.emplace_back();
+            fragments.back().path = directoryPath + separator + name;
+        }
+
+        // every worker parses the next file into its own layer, this object is only read by the
+        // workers until all of them have finished
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = static_cast<unsigned>(std::min<size_t>(threads, fragments.size()));
+        std::atomic<size_t> next(0);
+        auto worker = [this, &fragments, &next]() {
+            for (size_t i = next++; i < fragments.size(); i = next++) {
+                DirectoryFragment& fragment = fragments[i];
+                ConfigFile file;
+                if (!file.open(fragment.path)) {
+                    // like a file which cannot be parsed, the layer of the directory is kept
+                    log(fragment.values, LogLevel::WARNING, fragment.path, "unable to read config file");
+                    fragment.values.malformed = true;
+                    fragment.success = false;
+                } else if (file.size() >= sizeof(BINARY_MAGIC) && memcmp(file.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+                    fragment.binary = true;
+                } else {
+                    fragment.success = load(fragment.values, fragment.path, file.data(), file.size());
+                }
+            }
+        };
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : pool) {
+            thread.join();
+        }
+
+        // merge the fragments into the layer of the directory, a later file overwrites earlier ones;
+        // the directory is loaded like a single file by config(): the values which are rejected
+        // are skipped, a file which cannot be read or parsed leaves the layer as it was
+        bool success = true;
+        Layer values;
+        for (DirectoryFragment& fragment : fragments) {
+            SlotTable& slotTable = fragment.slotTable;
+            for (std::string& line : slotTable.log) {
+                if (_verbose) {
+                    fprintf(stdout, "%s\n", line.c_str());
+                }
+                _log.push_back(std::move(line));
+            }
+            if (fragment.binary) {
+                ConfigFile file;
+                if (!file.open(fragment.path)) {
+                    log(LogLevel::WARNING, fragment.path, "unable to read config file");
+                    values.malformed = true;
+                    fragment.success = false;
+                } else {
+                    fragment.success = load(values, fragment.path, file.data(), file.size());
+                }
+            } else if (fragment.values.malformed) {
+                values.malformed = true;
+            } else {
+                for (size_t i = 0; i < fragment.values.slots.size(); ++i) {
+                    size_t slot = fragment.values.slots[i];
+                    const std::string& flag = slotTable.flags[slot];
+                    values.assign(acquireSlot(flag.data(), flag.size(), slotTable.flagHashes[slot])) = std::move(fragment.values.values[i]);
+                }
+            }
+            success = fragment.success && success;
+        }
+        if (values.malformed) {
+            log(LogLevel::WARNING, directoryPath, "unable to load config directory, values are unchanged");
+            return false;
+        }
+        beginBatch();
+        replaceLayer(acquireLayer(Source::FILE, directoryPath), values);
+        endBatch();
+        log(LogLevel::INFO, directoryPath, "config directory is loaded");
+        return success;
+#else
+        (void) threads;
+        log(LogLevel::WARNING, directoryPath, "config directories are not supported on this system");
+        return false;
+#endif
+    }
+
+    bool Config::environment(const std::string& prefix, char** env)
+    {
+        if (env == nullptr) {
+            env = MINICONF_ENVIRON;
+        }
+        // the variables are matched against all options
+        loadMappedEntries();
+        std::string head(prefix);
+        if (!head.empty() && head.back() != '_') {
+            head.push_back('_');
+        }
+
+        // options indexed by the hash of their lower case flag, so every variable is resolved
+        // with one lookup, e.g. MYAPP_NUMOPT matches "numOpt"
+        std::vector<size_t> options(16, 0);
+        while (options.size() < _flags.size() * 2) {
+            options.resize(options.size() * 2);
+        }
+        size_t mask = options.size() - 1;
+        std::string flag;
+        for (size_t slot = 0; slot < _flags.size(); ++slot) {
+            if (!hasOption(slot)) {
+                continue;
+            }
+            flag.resize(_flags[slot].size());
+            std::transform(_flags[slot].begin(), _flags[slot].end(), flag.begin(), [](char c) {
+                return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            });
+            size_t bucket = hashFlag(flag.data(), flag.size()) & mask;
+            while (options[bucket] != 0) {
+                bucket = (bucket + 1) & mask;
+            }
+            options[bucket] = slot + 1;
+        }
+
+        // a single pass over the environment, MYAPP_PART2__SUBPART1__VALUE1 -> part2.subpart1.value1
+        bool success = true;
+        Layer values;
+        Layer* loading = _loading;
+        _loading = &values;
+        for (char** entry = env; entry != nullptr && *entry != nullptr; ++entry) {
+            const char* name = *entry;
+            if (strncmp(name, head.c_str(), head.size()) != 0) {
+                continue;
+            }
+            const char* separator = strchr(name, '=');
+            if (separator == nullptr) {
+                continue;
+            }
+            flag.clear();
+            for (const char* c = name + head.size(); c != separator; ++c) {
+                if (*c == '_' && c + 1 != separator && *(c + 1) == '_') {
+                    flag.push_back('.');
+                    ++c;
+                } else {
+                    flag.push_back((*c >= 'A' && *c <= 'Z') ? static_cast<char>(*c - 'A' + 'a') : *c);
+                }
+            }
+            size_t slot = NO_SLOT;
+            for (size_t bucket = hashFlag(flag.data(), flag.size()) & mask; options[bucket] != 0; bucket = (bucket + 1) & mask) {
+                const std::string& optionFlag = _flags[options[bucket] - 1];
+                if (equalsIgnoreCase(optionFlag.data(), optionFlag.data() + optionFlag.size(), flag.c_str())) {
+                    slot = options[bucket] - 1;
+                    break;
+                }
+            }
+            // unlike config files, the environment is shared with other programs
+            if (slot == NO_SLOT) {
+                log(LogLevel::INFO, std::string(name, separator), "environment variable does not match an option, it is ignored");
+                continue;
+            }
+            Value value = parseValue(separator + 1, separator + 1 + strlen(separator + 1), _options[slot].type());
+            if (value.isEmpty()) {
+                log(LogLevel::WARNING, std::string(name, separator), "unvalid value type is provided");
+                success = false;
+                continue;
+            }
+            assignSlot(slot) = std::move(value);
+            log(LogLevel::INFO, _flags[slot].c_str(), "value is loaded from environment");
+        }
+        _loading = loading;
+
+        beginBatch();
+        replaceLayer(acquireLayer(Source::ENVIRONMENT, head), values);
+        endBatch();
+        return success;
+    }
+
+    bool Config::attachBinary(const std::string& configPath, std::unique_ptr<MappedSnapshot>& mapped)
+    {
+        // a snapshot which cannot be opened leaves the layer of the file and its previous snapshot as they were
+        mapped->file.randomAccess();
+        BinaryReader& reader = mapped->reader;
+        if (!reader.open(this, configPath, mapped->file.data(), mapped->file.size())) {
+            log(LogLevel::WARNING, configPath, "unable to load config file, values are unchanged");
+            return false;
+        }
+        size_t layer = acquireLayer(Source::FILE, configPath);
+        detachBinary(layer);
+        mapped->layer = layer;
+
+        // the entries of the existing slots replace the values of the layer, and the entries
+        // validate() acts on are loaded; a slot added later loads its entry in acquireSlot()
+        bool success = true;
+        Layer values;
+        size_t slots = _flags.size();
+        for (size_t existing = 0; existing < slots; ++existing) {
+            const std::string& flag = _flags[existing];
+            size_t entry = reader.find(flag.data(), flag.size(), binaryFlagHash(flag.data(), flag.size()));
+            size_t slot;
+            Value value;
+            if (entry == NO_SLOT) {
+                continue;
+            } else if (!loadBinaryEntry(reader, entry, slot, value)) {
+                success = false;
+            } else if (value.type() != Value::DataType::UNKNOWN) {
+                values.assign(slot) = std::move(value);
+            }
+        }
+        for (size_t i = 0; i < reader.pinnedCount(); ++i) {
+            size_t entry = reader.pinned(i);
+            const char* flag;
+            size_t length;
+            size_t slot;
+            Value value;
+            if (entry == NO_SLOT || !reader.flag(entry, flag, length)) {
+                success = false;
+            } else if (findSlot(flag, length) != NO_SLOT) {
+                continue;
+            } else if (!loadBinaryEntry(reader, entry, slot, value)) {
+                success = false;
+            } else if (value.type() != Value::DataType::UNKNOWN) {
+                values.assign(slot) = std::move(value);
+            }
         }
+        beginBatch();
+        replaceLayer(layer, values);
+        _mappedSnapshots.push_back(std::move(mapped));
+        log(LogLevel::INFO, configPath, "binary snapshot is attached, its entries are loaded when they are looked up");
+        endBatch();
+        return success;
+    }
 
-        // print usage
-        usage();
-        // print help
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "HELP");
-        for (auto && opt : _options) {
-            Option& o = opt.second;
-            // print short
-            fprintf(fd, "    ");
-            if (!o.shortflag().empty()) {
-                fprintf(fd, "-%s, ", o.shortflag().c_str());
+    void Config::detachBinary(size_t layer)
+    {
+        for (size_t i = 0; i < _mappedSnapshots.size(); ++i) {
+            if (_mappedSnapshots[i]->layer == layer) {
+                _mappedSnapshots.erase(_mappedSnapshots.begin() + i);
+                return;
             }
-            // print long
-            fprintf(fd, "--%s ", o.flag().c_str());
-            // required
-            if (o.required()) {
-                fprintf(fd, "<REQUIRED>");
+        }
+    }
+
+    void Config::loadMappedSlot(size_t slot)
+    {
+        // every snapshot providing the flag assigns the value of its layer, the value of the layer
+        // with the highest precedence is the value of the slot
+        const std::string& flag = _flags[slot];
+        uint64_t hash = binaryFlagHash(flag.data(), flag.size());
+        for (std::unique_ptr<MappedSnapshot>& mapped : _mappedSnapshots) {
+            size_t entry = mapped->reader.find(flag.data(), flag.size(), hash);
+            Value value;
+            if (entry == NO_SLOT || !loadBinaryEntry(mapped->reader, entry, slot, value) || value.type() == Value::DataType::UNKNOWN) {
+                continue;
+            }
+            size_t provider = _slotLayers[slot];
+            if (provider == NO_SLOT || _layers[provider].rank < _layers[mapped->layer].rank) {
+                _optionValues[slot] = value;
+                _slotStates[slot] |= SLOT_VALUE;
+                _slotLayers[slot] = mapped->layer;
+            }
+            _layers[mapped->layer].assign(slot) = std::move(value);
+        }
+    }
+
+    void Config::loadMappedEntries()
+    {
+        // adding the slots loads the entries, the snapshots are detached once every entry is in a slot
+        for (size_t i = 0; i < _mappedSnapshots.size(); ++i) {
+            BinaryReader& reader = _mappedSnapshots[i]->reader;
+            for (size_t entry = 0; entry < reader.count(); ++entry) {
+                const char* flag;
+                size_t length;
+                if (reader.flag(entry, flag, length)) {
+                    acquireSlot(flag, length);
+                }
+            }
+        }
+        _mappedSnapshots.clear();
+    }
+
+    size_t Config::lookupSlot(const char* flag, size_t length)
+    {
+        size_t hash = hashFlag(flag, length);
+        size_t slot = findSlot(flag, length, hash);
+        if (slot != NO_SLOT || _mappedSnapshots.empty()) {
+            return slot;
+        }
+        uint64_t binaryHash = binaryFlagHash(flag, length);
+        for (std::unique_ptr<MappedSnapshot>& mapped : _mappedSnapshots) {
+            if (mapped->reader.find(flag, length, binaryHash) != NO_SLOT) {
+                return acquireSlot(flag, length, hash);
+            }
+        }
+        return NO_SLOT;
+    }
+
+    size_t Config::lookupSlot(const std::string& flag)
+    {
+        return lookupSlot(flag.data(), flag.size());
+    }
+
+    // size and modification time of a file, used to skip reading unchanged files
+    struct FileStamp {
+        bool exists;
+        unsigned long long size;
+        long long modified;     // nanoseconds since the epoch where available
+        unsigned long long inode;
+
+        bool operator==(const FileStamp& other) const
+        {
+            return exists == other.exists && size == other.size && modified == other.modified && inode == other.inode;
+        }
+    };
+
+    static FileStamp stampFile(const std::string& path)
+    {
+        FileStamp stamp = { false, 0, 0, 0 };
+#ifdef MINICONF_MMAP_SUPPORT
+        struct stat status;
+        if (stat(path.c_str(), &status) == 0) {
+            stamp.exists = true;
+            stamp.size = static_cast<unsigned long long>(status.st_size);
+            stamp.inode = static_cast<unsigned long long>(status.st_ino);
+#if defined(__APPLE__)
+            stamp.modified = static_cast<long long>(status.st_mtimespec.tv_sec) * 1000000000LL + status.st_mtimespec.tv_nsec;
+#else
+            stamp.modified = static_cast<long long>(status.st_mtim.tv_sec) * 1000000000LL + status.st_mtim.tv_nsec;
+#endif
+        }
+#else
+        // without stat() the content hash is the only check
+        std::ifstream ifd(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (ifd) {
+            stamp.exists = true;
+            stamp.size = static_cast<unsigned long long>(ifd.tellg());
+            stamp.modified = -1;
+        }
+#endif
+        return stamp;
+    }
+
+    /* A config file watched for changes
+     *
+     * With inotify the directory of the file is watched, since editors and snapshot() replace
+     * a file by renaming a new one over it, which a watch on the file itself would not see.
+     * Without inotify, or when the directory cannot be watched, the file is stat()ed instead.
+     */
+    class Config::Watcher
+    {
+        public:
+
+            Watcher(const std::string& path, ChangeCallback callback) :
+                    _path(path), _callback(std::move(callback)), _hash(0), _notify(-1)
+            {
+                _stamp = stampFile(path);
+#ifdef MINICONF_INOTIFY_SUPPORT
+                std::vector<char> dirPath(path.begin(), path.end());
+                dirPath.push_back('\0');
+                std::vector<char> basePath(dirPath);
+                _name = basename(basePath.data());
+                _notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+                if (_notify >= 0 && inotify_add_watch(_notify, dirname(dirPath.data()),
+                        IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM) < 0) {
+                    close(_notify);
+                    _notify = -1;
+                }
+#endif
+            }
+
+            ~Watcher()
+            {
+#ifdef MINICONF_INOTIFY_SUPPORT
+                if (_notify >= 0) {
+                    close(_notify);
+                }
+#endif
+            }
+
+            // waits up to timeoutMs milliseconds until the file may have changed
+            bool wait(int timeoutMs)
+            {
+                std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+                while (true) {
+                    int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                            deadline - std::chrono::steady_clock::now()).count());
+                    remaining = std::max(remaining, 0);
+#ifdef MINICONF_INOTIFY_SUPPORT
+                    if (_notify >= 0) {
+                        struct pollfd pfd = { _notify, POLLIN, 0 };
+                        int ready = ::poll(&pfd, 1, remaining);
+                        if (ready > 0 && readEvents()) {
+                            return true;
+                        }
+                        if (ready < 0 && errno != EINTR) {
+                            return false;
+                        }
+                        if (remaining == 0) {
+                            return false;
+                        }
+                        continue;
+                    }
+#endif
+                    if (!(stampFile(_path) == _stamp)) {
+                        return true;
+                    }
+                    if (remaining == 0) {
+                        return false;
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(remaining, 100)));
+                }
+            }
+
+            // the watched file
+            std::string _path;
+
+            // receives the changed values
+            ChangeCallback _callback;
+
+            // stamp of the file when it was last checked
+            FileStamp _stamp;
+
+            // hash of the content when it was last loaded
+            size_t _hash;
+
+        private:
+
+            Watcher(const Watcher&);
+            Watcher& operator=(const Watcher&);
+
+#ifdef MINICONF_INOTIFY_SUPPORT
+            // drains the pending events, returns true if any of them refers to the watched file
+            bool readEvents()
+            {
+                alignas(struct inotify_event) char buffer[4096];
+                bool matched = false;
+                while (true) {
+                    ssize_t count = read(_notify, buffer, sizeof(buffer));
+                    if (count <= 0) {
+                        break;
+                    }
+                    for (char* c = buffer; c < buffer + count; ) {
+                        const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(c);
+                        if (event->len != 0 && _name == event->name) {
+                            matched = true;
+                        }
+                        c += sizeof(struct inotify_event) + event->len;
+                    }
+                }
+                return matched;
+            }
+
+            // file name of the watched file within the watched directory
+            std::string _name;
+#endif
+
+            // inotify instance, or -1 when the file is polled
+            int _notify;
+    };
+
+    bool Config::watch(ChangeCallback callback, const std::string& configPath)
+    {
+        const std::string& path = configPath.empty() ? _configPath : configPath;
+        if (path.empty()) {
+            log(LogLevel::WARNING, "", "no config file to watch");
+            return false;
+        }
+        _watcher.reset(new Watcher(path, std::move(callback)));
+
+        // the current content is the baseline for later changes
+        ConfigFile file;
+        if (_watcher->_stamp.exists && file.open(path)) {
+            _watcher->_hash = hashFlag(file.data(), file.size());
+        }
+        log(LogLevel::INFO, path, "config file is watched for changes");
+        return true;
+    }
+
+    void Config::unwatch()
+    {
+        _watcher.reset();
+    }
+
+    bool Config::poll(int timeoutMs)
+    {
+        if (!_watcher || !_watcher->wait(timeoutMs)) {
+            return false;
+        }
+
+        // skip files whose stamp or content has not changed
+        const std::string& path = _watcher->_path;
+        FileStamp stamp = stampFile(path);
+        if (stamp == _watcher->_stamp) {
+            return false;
+        }
+        _watcher->_stamp = stamp;
+        ConfigFile file;
+        if (!stamp.exists || !file.open(path)) {
+            log(LogLevel::WARNING, path, "unable to read watched config file");
+            return false;
+        }
+        size_t hash = hashFlag(file.data(), file.size());
+        if (hash == _watcher->_hash) {
+            return false;
+        }
+
+        // a reload which cannot be parsed is discarded, so the file is loaded again after the
+        // next change, rejected values are skipped like in config()
+        Layer values;
+        load(values, path, file.data(), file.size());
+        if (values.malformed) {
+            log(LogLevel::WARNING, path, "unable to reload config file, values are unchanged");
+            return false;
+        }
+        _watcher->_hash = hash;
+        log(LogLevel::INFO, path, "config file is reloaded");
+
+        // the subscribers are notified by the batch, the callback may call unwatch()
+        ChangeCallback callback = _watcher->_callback;
+        std::vector<size_t> changed;
+        beginBatch();
+        replaceLayer(acquireLayer(Source::FILE, path), values);
+        endBatch(&changed);
+        for (size_t slot : changed) {
+            if (callback) {
+                callback(_flags[slot], _optionValues[slot]);
+            }
+        }
+        return !changed.empty();
+    }
+
+    /* scans one CSV field starting at "c"
+     *
+     * A field is either plain text up to the next comma / line break, or enclosed in double
+     * quotes, where it may contain commas and line breaks and a quote is escaped as "". The
+     * field is returned as a range into the buffer; only a quoted field containing escaped
+     * quotes is unescaped into "scratch". Returns the position after the delimiter, and sets
+     * "lineEnd" when the field is the last one on its line and "error" when it is malformed.
+     */
+    enum class CSVFieldError {
+        NONE,
+        UNTERMINATED,   // the closing quote is missing, the field takes the rest of the buffer
+        TRAILING        // text between the closing quote and the delimiter, it is skipped
+    };
+
+    static const char* scanCSVField(const char* c, const char* end, const char*& fieldBegin, const char*& fieldEnd,
+                                    std::string& scratch, bool& lineEnd, CSVFieldError& error)
+    {
+        lineEnd = false;
+        error = CSVFieldError::NONE;
+        if (c != end && *c == '"') {
+            fieldBegin = ++c;
+            fieldEnd = end; // an unterminated quote takes the rest of the buffer
+            bool escaped = false;
+            while (c != end) {
+                const char* quote = static_cast<const char*>(memchr(c, '"', static_cast<size_t>(end - c)));
+                if (quote == nullptr) {
+                    if (escaped) {
+                        scratch.append(c, end);
+                    }
+                    c = end;
+                    error = CSVFieldError::UNTERMINATED;
+                    break;
+                }
+                if (quote + 1 != end && *(quote + 1) == '"') {
+                    // escaped quote, continue into the unescaping buffer
+                    if (!escaped) {
+                        scratch.clear();
+                        escaped = true;
+                    }
+                    scratch.append(c, quote + 1);
+                    c = quote + 2;
+                    continue;
+                }
+                if (escaped) {
+                    scratch.append(c, quote);
+                }
+                fieldEnd = quote;
+                c = quote + 1;
+                break;
+            }
+            if (escaped) {
+                fieldBegin = scratch.data();
+                fieldEnd = scratch.data() + scratch.size();
+            }
+            // skip anything between the closing quote and the delimiter, except a carriage return
+            const char* trailing = c;
+            while (c != end && *c != ',' && *c != '\n') {
+                ++c;
+            }
+            if (c != trailing && !(c - trailing == 1 && *trailing == '\r')) {
+                error = CSVFieldError::TRAILING;
+            }
+        } else {
+            fieldBegin = c;
+            while (c != end && *c != ',' && *c != '\n') {
+                ++c;
+            }
+            fieldEnd = c;
+            if (fieldEnd != fieldBegin && *(fieldEnd - 1) == '\r' && (c == end || *c == '\n')) {
+                --fieldEnd;
+            }
+        }
+        if (c == end || *c == '\n') {
+            lineEnd = true;
+        }
+        return (c == end) ? c : c + 1;
+    }
+
+    bool Config::loadCSV(Layer& values, const char* CSVData, size_t size, const std::string& section)
+    {
+        const char* c = CSVData;
+        const char* end = CSVData + size;
+        bool success = true;
+
+        // scratch buffers for unescaped quoted fields, usually never used
+        std::string flagScratch;
+        std::string valueScratch;
+
+        // flags within a section are prefixed with the section, the hash of the prefix is reused
+        std::string sectionFlag(section);
+        size_t sectionHash = FLAG_HASH_SEED;
+        if (!section.empty()) {
+            sectionFlag.push_back('.');
+            sectionHash = hashFlag(sectionFlag.data(), sectionFlag.size());
+        }
+
+        // line numbers are only counted for the warnings, up to the row of the last one
+        size_t line = 1;
+        const char* counted = CSVData;
+        const char* row = CSVData;
+        auto rowLine = [&]() {
+            line += std::count(counted, row, '\n');
+            counted = row;
+            return std::to_string(line);
+        };
+
+        while (c != end) {
+            // skip empty lines
+            if (*c == '\n' || *c == '\r') {
+                ++c;
+                continue;
+            }
+            // each line contains one or more flag,value pairs
+            row = c;
+            bool lineEnd = false;
+            while (!lineEnd) {
+                const char* flagBegin = nullptr;
+                const char* flagEnd = nullptr;
+                const char* valueBegin = nullptr;
+                const char* valueEnd = nullptr;
+                CSVFieldError flagError;
+                CSVFieldError valueError = CSVFieldError::NONE;
+                c = scanCSVField(c, end, flagBegin, flagEnd, flagScratch, lineEnd, flagError);
+                if (!lineEnd) {
+                    c = scanCSVField(c, end, valueBegin, valueEnd, valueScratch, lineEnd, valueError);
+                }
+                if (flagError == CSVFieldError::UNTERMINATED || valueError == CSVFieldError::UNTERMINATED) {
+                    // the rest of the file is in the field, nothing after the quote can be trusted
+                    log(values, LogLevel::WARNING, std::string(flagBegin, flagEnd), "unterminated quoted field, the rest of the file is not loaded, line " + rowLine());
+                    values.malformed = true;
+                    return false;
+                }
+                if (flagError == CSVFieldError::TRAILING || valueError == CSVFieldError::TRAILING) {
+                    log(values, LogLevel::WARNING, std::string(flagBegin, flagEnd), "text after a closing quote is ignored, line " + rowLine());
+                }
+                if (valueBegin == nullptr) {
+                    // a trailing comma leaves an empty flag at the end of the line
+                    if (flagBegin != flagEnd) {
+                        log(values, LogLevel::WARNING, std::string(flagBegin, flagEnd), "no value is provided, line " + rowLine());
+                    }
+                    break;
+                }
+                if (valueBegin == valueEnd) {
+                    continue;
+                }
+                // check if options exists
+                size_t slot = NO_SLOT;
+                size_t flagLength = static_cast<size_t>(flagEnd - flagBegin);
+                if (section.empty()) {
+                    slot = loadSlot(values, flagBegin, flagLength, hashFlag(flagBegin, flagLength));
+                } else {
+                    sectionFlag.resize(section.size() + 1);
+                    sectionFlag.append(flagBegin, flagLength);
+                    slot = loadSlot(values, sectionFlag.data(), sectionFlag.size(), hashFlag(flagBegin, flagLength, sectionHash));
+                }
+                const Option* option = loadedOption(values, slot);
+                if (option != nullptr) {
+                    // parse the default data type
+                    Value value = parseValue(valueBegin, valueEnd, option->_defaultValue.type());
+                    if (value.isEmpty()) {
+                        log(values, LogLevel::WARNING, loadedFlag(values, slot), "unvalid value type is provided, line " + rowLine());
+                        success = false;
+                        continue;
+                    }
+                    values.assign(slot) = std::move(value);
+                    log(values, LogLevel::INFO, loadedFlag(values, slot), "value is loaded from config");
+                } else {
+                    // parse string when the flag does not exist in the original configuration
+                    values.assign(slot) = parseValue(valueBegin, valueEnd, Value::DataType::STRING);
+                    log(values, LogLevel::INFO, loadedFlag(values, slot), "value is not defined in config, parsed as a string value");
+                }
+            }
+        }
+        return success;
+    }
+
+#ifdef MINICONF_JSON_SUPPORT
+    /* converts a JSON number to the width of an integer or number option
+     *
+     * Integers are range checked exactly. Numbers are accepted for integer options if they have
+     * no fraction, like integer values on the command line and in CSV files, and are range
+     * checked as well. Other values and types are left as they are.
+     *
+     * @return False if the value has a fraction or is out of the range of the option type
+     */
+    static bool convertJSONNumber(Value& value, Value::DataType type)
+    {
+        if (value.type() == Value::DataType::INT) {
+            // the items of integer arrays
+            if (type == Value::DataType::INT64) {
+                value = static_cast<int64_t>(value.getInt());
+            } else if (type == Value::DataType::NUMBER) {
+                value = static_cast<double>(value.getInt());
+            }
+        } else if (value.type() == Value::DataType::INT64) {
+            int64_t integer = value.getInt64();
+            if (type == Value::DataType::INT) {
+                if (integer < std::numeric_limits<int>::min() || integer > std::numeric_limits<int>::max()) {
+                    return false;
+                }
+                value = static_cast<int>(integer);
+            } else if (type == Value::DataType::NUMBER) {
+                value = static_cast<double>(integer);
+            }
+        } else if (value.type() == Value::DataType::NUMBER) {
+            // the bounds are exclusive and exact as doubles, NaN fails both comparisons
+            double number = value.getNumber();
+            if ((type == Value::DataType::INT || type == Value::DataType::INT64) && std::trunc(number) != number) {
+                return false;
+            }
+            if (type == Value::DataType::INT) {
+                if (!(number > -2147483649.0 && number < 2147483648.0)) {
+                    return false;
+                }
+                value = static_cast<int>(number);
+            } else if (type == Value::DataType::INT64) {
+                if (!(number >= -9223372036854775808.0 && number < 9223372036854775808.0)) {
+                    return false;
+                }
+                value = static_cast<int64_t>(number);
+            }
+        }
+        return true;
+    }
+
+    /* converts a string written for a non-finite number by writeJSONValue(), e.g. "nan" or "-inf"
+     *
+     * @return False if the value is not such a string, it is then left as it is
+     */
+    static bool convertNonFinite(Value& value)
+    {
+        double number = 0.0;
+        if (value.type() != Value::DataType::STRING || 
+                !parseNumber(value.getCharArray(), value.getCharArray() + value.size(), number) || std::isfinite(number)) {
+            return false;
+        }
+        value = number;
+        return true;
+    }
+
+    bool Config::assignJSONValue(Layer& values, const std::string& flag, size_t hash, Value&& value)
+    {
+        size_t slot = loadSlot(values, flag.data(), flag.size(), hash);
+        const Option* option = loadedOption(values, slot);
+        if (option != nullptr) {
+            Value::DataType type = option->_defaultValue.type();
+            if (type == Value::DataType::NUMBER) {
+                convertNonFinite(value);
+            } else if (type == Value::DataType::NUMBER_ARRAY && value.type() == Value::DataType::STRING_ARRAY) {
+                std::vector<Value> items;
+                splitArray(value, items);
+                for (Value& item : items) {
+                    convertNonFinite(item);
+                }
+                value = makeArray(type, items);
+            }
+            if (!convertJSONNumber(value, type)) {
+                log(values, LogLevel::WARNING, flag, "Unable to parse the option from config file, the value is not an integer or out of range, flag = " + flag);
+                return false;
+            }
+            // JSON arrays of numbers are converted like numbers, an empty array takes the option type
+            bool numberArrays = (type == Value::DataType::INT_ARRAY || type == Value::DataType::NUMBER_ARRAY) &&
+                    (value.type() == Value::DataType::INT_ARRAY || value.type() == Value::DataType::NUMBER_ARRAY);
+            if (value.isArray() && (value.size() == 0 || (numberArrays && value.type() != type))) {
+                std::vector<Value> items;
+                splitArray(value, items);
+                for (Value& item : items) {
+                    if (!convertJSONNumber(item, Value::elementType(type))) {
+                        log(values, LogLevel::WARNING, flag, "Unable to parse the option from config file, the value is not an integer or out of range, flag = " + flag);
+                        return false;
+                    }
+                }
+                value = makeArray(type, items);
+            }
+            if (value.type() != type) {
+                log(values, LogLevel::WARNING, flag, "Unable to parse the option from config file, flag = " + flag);
+                return false;
+            }
+        }
+        // stray options keep the data type interpreted by the JSON file, integers are 64-bit integers
+        values.assign(slot) = std::move(value);
+        return true;
+    }
+
+    /* converts the token of a JSON number with the parsers of argv and CSV values
+     *
+     * Integers are read exactly, like picojson those beyond 64 bits are doubles. Used by
+     * both JSON parsers, so a number is read the same way in every config file.
+     *
+     * @return False if the token is not a complete number
+     */
+    static bool parseJSONNumber(const char* begin, const char* end, Value& out)
+    {
+        int64_t integer = 0;
+        double number = 0.0;
+        if (parseInteger(begin, end, integer)) {
+            out = integer;
+        } else if (parseNumber(begin, end, number)) {
+            out = number;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    class Config::JSONContext
+    {
+        public:
+
+            // values are assigned to the flags relative to a section
+            JSONContext(Config* config, Layer& values, const std::string& section) : 
+                    _config(config), _values(&values), _path(section), _hash(hashFlag(section.data(), section.size())), 
+                    _arrayDepth(0), _arrayValid(true), _success(true) {}
+
+            // null has no type, it is rejected for an option and skipped for a stray flag, an
+            // array containing null is rejected
+            bool set_null()
+            {
+                if (_arrayDepth != 0) {
+                    _arrayValid = false;
+                    return true;
+                }
+                size_t slot = _config->loadSlot(*_values, _path.data(), _path.size(), _hash);
+                if (_config->loadedOption(*_values, slot) != nullptr) {
+                    _config->log(*_values, LogLevel::WARNING, _path, "Unable to parse the option from config file, null is not a value, flag = " + _path);
+                    _success = false;
+                } else {
+                    _config->log(*_values, LogLevel::WARNING, _path, "null value is skipped, flag = " + _path);
+                }
+                return true;
+            }
+
+            bool set_bool(bool b)
+            {
+                return assign(Value(b));
+            }
+
+            bool set_number(double f)
+            {
+                return assign(Value(f));
+            }
+
+            // integers are assigned exactly, the option type decides the width in assignJSONValue()
+            bool set_int64(int64_t i)
+            {
+                return assign(Value(i));
+            }
+
+            // converts a number token instead of picojson, see parseJSONNumber()
+            bool parse_number(const char* begin, const char* end)
+            {
+                Value number;
+                return parseJSONNumber(begin, end, number) && assign(std::move(number));
+            }
+
+            template <typename Iter> bool parse_string(picojson::input<Iter>& in)
+            {
+                _string.clear();
+                if (!picojson::_parse_string(_string, in)) {
+                    return false;
+                }
+                return set_string(_string.data(), _string.size());
+            }
+
+            // assigns an unescaped string
+            bool set_string(const char* data, size_t size)
+            {
+                return assign(Value(data, size));
+            }
+
+            // the items of an array are collected and assigned as one value, nested arrays and
+            // objects within an array are not supported and skipped
+            bool parse_array_start()
+            {
+                if (_arrayDepth++ == 0) {
+                    _items.clear();
+                    _arrayValid = true;
+                } else {
+                    _arrayValid = false;
+                }
+                return true;
+            }
+
+            // checks if the items of the current array are skipped
+            bool skipArrayItem() const
+            {
+                return _arrayDepth > 1;
+            }
+
+            template <typename Iter> bool parse_array_item(picojson::input<Iter>& in, size_t)
+            {
+                if (skipArrayItem()) {
+                    picojson::null_parse_context skip;
+                    return picojson::_parse(skip, in);
+                }
+                return picojson::_parse(*this, in);
+            }
+
+            bool parse_array_stop(size_t)
+            {
+                if (--_arrayDepth != 0) {
+                    return true;
+                }
+                // the non-finite items of number arrays are written as strings, an array of
+                // numbers and such strings is a number array
+                bool numbers = false;
+                for (const Value& item : _items) {
+                    numbers = numbers || item.type() == Value::DataType::INT64 || item.type() == Value::DataType::NUMBER;
+                }
+                if (numbers) {
+                    for (Value& item : _items) {
+                        convertNonFinite(item);
+                    }
+                }
+                // there are no 64-bit integer arrays: integer items are kept exact in an integer
+                // array if they all fit into int, otherwise they are numbers
+                bool integers = true;
+                for (const Value& item : _items) {
+                    integers = integers && item.type() == Value::DataType::INT64 && 
+                            item.getInt64() >= std::numeric_limits<int>::min() && item.getInt64() <= std::numeric_limits<int>::max();
+                }
+                for (Value& item : _items) {
+                    convertJSONNumber(item, integers ? Value::DataType::INT : Value::DataType::NUMBER);
+                }
+                Value array = _arrayValid ? makeArray(Value::DataType::UNKNOWN, _items) : Value();
+                if (array.isEmpty()) {
+                    _config->log(*_values, LogLevel::WARNING, _path, "Unable to parse JSON array, elements must be values of the same type, flag = " + _path);
+                    _success = false;
+                    return true;
+                }
+                return assign(std::move(array));
+            }
+
+            bool parse_object_start()
+            {
+                if (_arrayDepth != 0) {
+                    _arrayValid = false;
+                }
+                return true;
+            }
+
+            // checks if the items of the current object are skipped
+            bool skipObjectItem() const
+            {
+                return _arrayDepth != 0;
+            }
+
+            template <typename Iter> bool parse_object_item(picojson::input<Iter>& in, const std::string& key)
+            {
+                if (skipObjectItem()) {
+                    picojson::null_parse_context skip;
+                    return picojson::_parse(skip, in);
+                }
+                pushKey(key.data(), key.size());
+                bool parsed = picojson::_parse(*this, in);
+                popKey();
+                return parsed;
+            }
+
+            // the dotted flag of an object item is appended to the path, and removed afterwards,
+            // the hash of the path is extended by the new segment only
+            void pushKey(const char* key, size_t length)
+            {
+                _scopes.push_back(std::make_pair(_path.size(), _hash));
+                if (!_path.empty()) {
+                    _path.push_back('.');
+                    _hash = hashFlag(".", 1, _hash);
+                }
+                _path.append(key, length);
+                _hash = hashFlag(key, length, _hash);
             }
-            fprintf(fd, "\n");
-            // print description
-            fprintf(fd, "        ");
-            if (!o.description().empty()) {
-                fprintf(fd, "%s ", o.description().c_str());
+
+            void popKey()
+            {
+                _path.resize(_scopes.back().first);
+                _hash = _scopes.back().second;
+                _scopes.pop_back();
             }
-            // default value
-            if (!o.defaultValue().isEmpty() && !o.hidden()) {
-                fprintf(fd, " ( ");
-                fprintf(fd, "DEFAULT = %s", o.defaultValue().print().c_str());
-                fprintf(fd, " ) ");
+
+            // checks if all values have been assigned
+            bool success() const
+            {
+                return _success;
             }
-            fprintf(fd, "\n\n");
-        }
-    }
 
-    void Config::usage(FILE* fd)
+        private:
+
+            JSONContext(const JSONContext&);
+            JSONContext& operator=(const JSONContext&);
+
+            // assigns a value to the current path, parsing continues on type mismatch, the
+            // items of an array are collected instead
+            bool assign(Value&& value)
+            {
+                if (_arrayDepth != 0) {
+                    _items.push_back(std::move(value));
+                    return true;
+                }
+                _success = _config->assignJSONValue(*_values, _path, _hash, std::move(value)) && _success;
+                return true;
+            }
+
+            // the config object reading the values, and the layer receiving them
+            Config* _config;
+            Layer* _values;
+
+            // dotted flag of the value being parsed
+            std::string _path;
+
+            // hash of _path
+            size_t _hash;
+
+            // length and hash of the path before each key pushed by pushKey()
+            std::vector<std::pair<size_t, size_t> > _scopes;
+
+            // reusable buffer for string values
+            std::string _string;
+
+            // nesting depth of arrays, and the items of the outermost array
+            size_t _arrayDepth;
+            std::vector<Value> _items;
+
+            // the outermost array contains only values
+            bool _arrayValid;
+
+            // no value has been rejected
+            bool _success;
+    };
+
+    /* Two-stage JSON parser for contiguous buffers
+     *
+     * Stage 1 classifies the input in blocks of 64 bytes, one bit per byte, with SSE2 or AVX2
+     * compares where available. The quotes which are not escaped delimit the strings (a prefix
+     * XOR of the quote bits gives the bytes inside strings), and the positions of the structural
+     * characters, the quotes and the first byte of every other value outside strings are
+     * collected into an index. Control characters inside strings and invalid UTF-8 are rejected
+     * in the same pass. Stage 2 walks the index and drives a JSONContext like picojson does,
+     * strings without escapes and numbers are read in place.
+     */
+
+    // character classes of a 64 byte block, one bit per byte
+    struct JSONBlock {
+        uint64_t quote;         // '"'
+        uint64_t backslash;     // '\'
+        uint64_t structural;    // '{', '}', '[', ']', ':' and ','
+        uint64_t whitespace;    // space, tab, line feed and carriage return
+        uint64_t control;       // bytes below 0x20
+        uint64_t nonAscii;      // bytes from 0x80
+    };
+
+    typedef void (*JSONClassifier)(const unsigned char* block, JSONBlock& out);
+
+    static void classifyScalar(const unsigned char* block, JSONBlock& out)
     {
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "USAGE");
-        char exeTag[256];
-        snprintf(exeTag, 256 - 1, "    %s ", (_exeName.empty()) ? ("<executable>") : (_exeName.c_str()));
-        fprintf(fd, "%s", exeTag);
-        int lineWidth = 0;
-        for (auto && opt : _options) {
-            Option& o = opt.second;
-            char argTag[512];
-            snprintf(argTag, 512 - 1, "%s%s%s <%s>%s",
-                     o.required() ? "" : "[",
-                     o.shortflag().empty() ? "--" : "-",
-                     o.shortflag().empty() ? o.flag().c_str() : o.shortflag().c_str(),
-                     o.defaultValue().printType().c_str(),
-                     o.required() ? "" : "]");
-            if (lineWidth + strlen(argTag) >= 80 - 1 - strlen(exeTag)) {
-                fprintf(fd, "\n%*s", static_cast<int>(strlen(exeTag)), " ");
-                lineWidth = 0;
+        out = JSONBlock();
+        for (unsigned i = 0; i < 64; ++i) {
+            uint64_t bit = static_cast<uint64_t>(1) << i;
+            unsigned char c = block[i];
+            switch (c) {
+                case '"': out.quote |= bit; break;
+                case '\\': out.backslash |= bit; break;
+                case '{': case '}': case '[': case ']': case ':': case ',': out.structural |= bit; break;
+                case ' ': out.whitespace |= bit; break;
+                case '\t': case '\n': case '\r': out.whitespace |= bit; out.control |= bit; break;
+                default:
+                    if (c < 0x20) {
+                        out.control |= bit;
+                    } else if (c >= 0x80) {
+                        out.nonAscii |= bit;
+                    }
+                    break;
             }
-            fprintf(fd, "%s ", argTag);
-            lineWidth += strlen(argTag);
         }
-        fprintf(fd, "\n\n");
     }
 
-    void Config::description(const std::string& desc)
+#ifdef MINICONF_SIMD_SUPPORT
+    __attribute__((target("sse2")))
+    static void classifySSE2(const unsigned char* block, JSONBlock& out)
     {
-        _description = desc;
+        out = JSONBlock();
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i lowerCase = _mm_set1_epi8(0x20);
+        const __m128i openBrace = _mm_set1_epi8('{');
+        const __m128i closeBrace = _mm_set1_epi8('}');
+        const __m128i colon = _mm_set1_epi8(':');
+        const __m128i comma = _mm_set1_epi8(',');
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i lineFeed = _mm_set1_epi8('\n');
+        const __m128i carriageReturn = _mm_set1_epi8('\r');
+        const __m128i controlMax = _mm_set1_epi8(0x1f);
+        for (unsigned i = 0; i < 4; ++i) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+            // '[' and ']' differ from '{' and '}' by the 0x20 bit only
+            __m128i folded = _mm_or_si128(v, lowerCase);
+            __m128i structural = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+            __m128i whitespace = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, lineFeed), _mm_cmpeq_epi8(v, carriageReturn)));
+            __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(v, controlMax), v);
+            unsigned shift = 16 * i;
+            out.quote |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+            out.backslash |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+            out.structural |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(structural))) << shift;
+            out.whitespace |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(whitespace))) << shift;
+            out.control |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(control))) << shift;
+            out.nonAscii |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(v))) << shift;
+        }
     }
 
-    void Config::enableConfig(bool enabled)
+    __attribute__((target("avx2")))
+    static void classifyAVX2(const unsigned char* block, JSONBlock& out)
     {
-        _loadConfig = enabled;
-        if (_autoHelp && !findOption("config")) {
-            option("config").
-                    shortflag("cfg").
-                    defaultValue("").
-                    description("Input configuration file (JSON/CSV)").
-                    required(false).hidden(true);
-        } else {
-            if (findOption("config")) {
-                _options.erase("config");
-            }
+        out = JSONBlock();
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i lowerCase = _mm256_set1_epi8(0x20);
+        const __m256i openBrace = _mm256_set1_epi8('{');
+        const __m256i closeBrace = _mm256_set1_epi8('}');
+        const __m256i colon = _mm256_set1_epi8(':');
+        const __m256i comma = _mm256_set1_epi8(',');
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i lineFeed = _mm256_set1_epi8('\n');
+        const __m256i carriageReturn = _mm256_set1_epi8('\r');
+        const __m256i controlMax = _mm256_set1_epi8(0x1f);
+        for (unsigned i = 0; i < 2; ++i) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+            __m256i folded = _mm256_or_si256(v, lowerCase);
+            __m256i structural = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+            __m256i whitespace = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, lineFeed), _mm256_cmpeq_epi8(v, carriageReturn)));
+            __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(v, controlMax), v);
+            unsigned shift = 32 * i;
+            out.quote |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+            out.backslash |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+            out.structural |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(structural))) << shift;
+            out.whitespace |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(whitespace))) << shift;
+            out.control |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(control))) << shift;
+            out.nonAscii |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(v))) << shift;
         }
-
     }
+#endif
 
-    void Config::enableHelp(bool enabled)
+    // selects the classifier of a parser, falling back to the widest instruction set supported by the CPU
+    static JSONClassifier selectClassifier(Config::JSONParser parser)
     {
-        _autoHelp = enabled;
-        if (_autoHelp && !findOption("help")) {
-            option("help").
-                    shortflag("h").
-                    defaultValue(false).
-                    description("Display the help message").
-                    required(false).hidden(true);
-        } else {
-            if (findOption("help")) {
-                _options.erase("help");
-            }
+#ifdef MINICONF_SIMD_SUPPORT
+        __builtin_cpu_init();
+        if ((parser == Config::JSONParser::AUTO || parser == Config::JSONParser::AVX2) && __builtin_cpu_supports("avx2")) {
+            return classifyAVX2;
         }
+        if (parser != Config::JSONParser::SCALAR && __builtin_cpu_supports("sse2")) {
+            return classifySSE2;
+        }
+#else
+        (void) parser;
+#endif
+        return classifyScalar;
     }
 
-    void Config::verbose(bool value)
+    static unsigned countTrailingZeros(uint64_t bits)
     {
-        _verbose = value;
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+        unsigned count = 0;
+        for (; (bits & 1) == 0; bits >>= 1) {
+            ++count;
+        }
+        return count;
+#endif
     }
 
-    bool Config::contains(const std::string& flag)
+    // bits of the bytes escaped by a backslash, "carry" is set if the block ends with an escaping backslash
+    static uint64_t escapedBytes(uint64_t backslash, bool& carry)
     {
-        return _optionValues.find(flag) != _optionValues.end();
+        uint64_t escaped = 0;
+        if (carry) {
+            // the first byte is escaped, and cannot escape the next one
+            escaped = 1;
+            backslash &= ~static_cast<uint64_t>(1);
+            carry = false;
+        }
+        // backslashes are rare in config files, they are resolved one by one
+        while (backslash != 0) {
+            unsigned position = countTrailingZeros(backslash);
+            backslash &= backslash - 1;
+            if (position == 63) {
+                carry = true;
+                break;
+            }
+            escaped |= static_cast<uint64_t>(2) << position;
+            backslash &= ~(static_cast<uint64_t>(2) << position);
+        }
+        return escaped;
     }
 
-    Value& Config::operator[](const std::string& flag)
+    // sets every bit to the XOR of itself and all lower bits
+    static uint64_t prefixXor(uint64_t bits)
     {
-        return _optionValues[flag];
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
     }
 
-    Value const &Config::operator[](const std::string &flag) const {
-        return _optionValues.at(flag);
-    }
+    // state of the UTF-8 validation between blocks
+    struct UTF8State {
+        unsigned pending;       // continuation bytes expected
+        unsigned char lower;    // range of the next continuation byte, narrower after some lead bytes
+        unsigned char upper;
+    };
 
-    void Config::print(FILE* fd)
+    // validates UTF-8, rejecting overlong forms, surrogates and code points above U+10FFFF,
+    // returns the offset of the first invalid byte, or "length" if all bytes are valid
+    static size_t validateUTF8(const unsigned char* bytes, size_t length, UTF8State& state)
     {
-        fprintf(fd, "\n[[[  %s  ]]]\n\n", "CONFIGURATION");
-
-        printf("|-------------------------|------------|--------------------------------------------------|\n");
-        printf("|           NAME          |    TYPE    |                     VALUE                        |\n");
-        printf("|-------------------------|------------|--------------------------------------------------|\n");
-        for (auto && v : _optionValues) {
-            if (_options.find(v.first.c_str()) != _options.end()) {
-                fprintf(fd, "| %-23s | %-10s | %-48s |\n", v.first.c_str(), v.second.printType().c_str(), v.second.print().c_str());
-            } else {
-                fprintf(fd, "| %-23s | %-10s | %-48s |\n", v.first.c_str(), (v.second.printType() + "*").c_str(), v.second.print().c_str());
+        for (size_t i = 0; i < length; ++i) {
+            unsigned char c = bytes[i];
+            if (state.pending != 0) {
+                if (c < state.lower || c > state.upper) {
+                    return i;
+                }
+                state.lower = 0x80;
+                state.upper = 0xbf;
+                --state.pending;
+            } else if (c >= 0x80) {
+                if (c >= 0xc2 && c <= 0xdf) {
+                    state.pending = 1;
+                } else if (c >= 0xe0 && c <= 0xef) {
+                    state.pending = 2;
+                    state.lower = (c == 0xe0) ? 0xa0 : 0x80;
+                    state.upper = (c == 0xed) ? 0x9f : 0xbf;
+                } else if (c >= 0xf0 && c <= 0xf4) {
+                    state.pending = 3;
+                    state.lower = (c == 0xf0) ? 0x90 : 0x80;
+                    state.upper = (c == 0xf4) ? 0x8f : 0xbf;
+                } else {
+                    return i;
+                }
             }
         }
-        printf("|-------------------------|------------|--------------------------------------------------|\n");
-        printf("\n");
+        return length;
     }
 
-    std::string Config::serialize(const std::string& serializeFilePath, ExportFormat format, bool pretty)
+    // appends a code point as UTF-8
+    static void appendUTF8(std::string& out, unsigned code)
     {
-        std::stringstream ss;
-        std::string outStr;
-
-        // extract extension
-        std::string extension = "";
-        size_t lastDot = serializeFilePath.find_last_of(".");
-        if (lastDot != std::string::npos) {
-            extension = serializeFilePath.substr(lastDot + 1);
-        }
-#ifdef MINICONF_JSON_SUPPORT
-        if (extension == "json" || extension == "JSON"){
-            format = ExportFormat::JSON;
-        } else if (extension == "csv" || extension == "CSV"){
-            format = ExportFormat::CSV;
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xc0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xe0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
         } else {
-            format = ExportFormat::CSV;
+            out.push_back(static_cast<char>(0xf0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3f)));
         }
-#else
-        format = ExportFormat::CSV;
-#endif
+    }
 
-        // serialize JSON
-#ifdef MINICONF_JSON_SUPPORT
-        if (format == ExportFormat::JSON) {
-            picojson::value outObj = picojson::value(picojson::object());
-            for (auto v: _optionValues){
-                std::vector<std::string> flagTokens;
-                std::stringstream ss(v.first);
-                // tokenize
-                while (ss.good()){
-                    std::string tempToken;
-                    std::getline(ss, tempToken, '.');
-                    flagTokens.emplace_back(tempToken);
-                }
-                // parse
-                if (flagTokens.size() > 1){
-                    picojson::value* thisObj = &outObj;
-                    for (size_t i = 0; i < flagTokens.size(); ++i){
-                        if (i != flagTokens.size() - 1){
-                            if (thisObj->get<picojson::object>().find(flagTokens[i]) == thisObj->get<picojson::object>().end()){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(picojson::object());
-                            }
-                            thisObj = &(thisObj->get<picojson::object>()[flagTokens[i]]);
-                        } else {
-                            if (v.second.type() == Value::DataType::INT){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(static_cast<double>(v.second.getInt()));
-                            } else if (v.second.type() == Value::DataType::NUMBER){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(v.second.getNumber());
-                            } else if (v.second.type() == Value::DataType::BOOL){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(v.second.getBoolean());
-                            } else if (v.second.type() == Value::DataType::STRING){
-                                thisObj->get<picojson::object>()[flagTokens[i]] = picojson::value(v.second.getString());
-                            }
+    // reads 4 hex digits of a \u escape
+    static bool parseHex4(const char* begin, const char* end, unsigned& code)
+    {
+        if (end - begin < 4) {
+            return false;
+        }
+        code = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = begin[i];
+            unsigned digit = 0;
+            if (c >= '0' && c <= '9') {
+                digit = static_cast<unsigned>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                digit = static_cast<unsigned>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                digit = static_cast<unsigned>(c - 'A' + 10);
+            } else {
+                return false;
+            }
+            code = (code << 4) | digit;
+        }
+        return true;
+    }
 
-                        }
+    // unescapes the content of a JSON string, surrogate pairs of \u escapes are combined
+    static bool unescapeJSON(const char* begin, const char* end, std::string& out)
+    {
+        out.clear();
+        while (begin != end) {
+            const char* backslash = static_cast<const char*>(memchr(begin, '\\', static_cast<size_t>(end - begin)));
+            if (backslash == nullptr) {
+                out.append(begin, end);
+                break;
+            }
+            out.append(begin, backslash);
+            if (backslash + 1 == end) {
+                return false;
+            }
+            begin = backslash + 2;
+            switch (backslash[1]) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    unsigned code = 0;
+                    if (!parseHex4(begin, end, code)) {
+                        return false;
+                    }
+                    begin += 4;
+                    if (code >= 0xdc00 && code <= 0xdfff) {
+                        return false;
                     }
-                }else{
-                    if (outObj.get<picojson::object>().find(flagTokens[0]) == outObj.get<picojson::object>().end()){
-                        if (v.second.type() == Value::DataType::INT){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(static_cast<double>(v.second.getInt()));
-                        } else if (v.second.type() == Value::DataType::NUMBER){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(v.second.getNumber());
-                        } else if (v.second.type() == Value::DataType::BOOL){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(v.second.getBoolean());
-                        }  else if (v.second.type() == Value::DataType::STRING){
-                            outObj.get<picojson::object>()[flagTokens[0]] = picojson::value(v.second.getString());
+                    if (code >= 0xd800 && code <= 0xdbff) {
+                        unsigned low = 0;
+                        if (end - begin < 6 || begin[0] != '\\' || begin[1] != 'u' || !parseHex4(begin + 2, end, low) ||
+                                low < 0xdc00 || low > 0xdfff) {
+                            return false;
                         }
+                        begin += 6;
+                        code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
                     }
+                    appendUTF8(out, code);
+                    break;
                 }
+                default:
+                    return false;
             }
-            outStr = outObj.serialize(true);
         }
-#endif
+        return true;
+    }
+
+    class Config::StructuralJSON
+    {
+        public:
+
+            StructuralJSON(const char* data, size_t size) :
+                    _data(data), _size(size), _end(size), _next(0), _depth(0), _error(0) {}
+
+            /* stage 1: builds the structural index
+             *
+             * Indexing stops at an unterminated string, a control character within a string or
+             * invalid UTF-8. This is an error only if the walk reaches it, the content after the
+             * first value is ignored like picojson does.
+             */
+            void index(JSONClassifier classify)
+            {
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(_data);
+                unsigned char padded[64];
+                uint64_t inString = 0;      // all bits set if the previous block ended inside a string
+                uint64_t scalarEnd = 0;     // 1 if the previous block ended within a scalar value
+                bool escapeCarry = false;
+                UTF8State utf8 = { 0, 0x80, 0xbf };
+                _index.clear();
+                _index.reserve(_size / 8 + 16);
+                _end = _size;
+                for (size_t offset = 0; offset < _size; offset += 64) {
+                    const unsigned char* block = bytes + offset;
+                    size_t length = std::min(_size - offset, static_cast<size_t>(64));
+                    if (length < 64) {
+                        // the last block is padded with whitespace
+                        memset(padded, ' ', sizeof(padded));
+                        memcpy(padded, block, length);
+                        block = padded;
+                    }
+                    JSONBlock masks;
+                    classify(block, masks);
+
+                    uint64_t quotes = masks.quote & ~escapedBytes(masks.backslash, escapeCarry);
+                    uint64_t strings = prefixXor(quotes) ^ inString;
+                    inString = static_cast<uint64_t>(static_cast<int64_t>(strings) >> 63);
+                    size_t invalid = 64;
+                    if ((masks.control & strings) != 0) {
+                        invalid = countTrailingZeros(masks.control & strings);
+                    }
+                    if (masks.nonAscii != 0 || utf8.pending != 0) {
+                        invalid = std::min(invalid, validateUTF8(block, length, utf8));
+                    }
 
-        // serialize CSV
-        if (format == ExportFormat::CSV) {
-            for (auto opt = std::begin(_optionValues); opt != std::end(_optionValues); ++opt) {
-                std::string flag = opt->first;
-                std::string val = opt->second.print();
-                if (opt->second.type() == Value::DataType::STRING){
-                    // remove "" from string
-                    if (val.size() >= 2){
-                        val = val.substr(1, val.size()-2);
+                    // the first byte of every run of scalar bytes, e.g. numbers and literals
+                    uint64_t scalars = ~(masks.structural | masks.whitespace | quotes | strings);
+                    uint64_t scalarStarts = scalars & ~((scalars << 1) | scalarEnd);
+                    scalarEnd = scalars >> 63;
+                    uint64_t structurals = (masks.structural & ~strings) | quotes | scalarStarts;
+                    if (invalid < length) {
+                        // only the positions before the invalid byte are indexed
+                        structurals &= (static_cast<uint64_t>(1) << invalid) - 1;
+                    }
+                    while (structurals != 0) {
+                        _index.push_back(static_cast<uint32_t>(offset + countTrailingZeros(structurals)));
+                        structurals &= structurals - 1;
+                    }
+                    if (invalid < length) {
+                        _end = offset + invalid;
+                        return;
                     }
                 }
-                ss << flag << "," << val << std::endl;
             }
-            outStr = ss.str();
-        }
 
-        // write out file
-        if (!serializeFilePath.empty()) {
-            std::ofstream ofd(serializeFilePath);
-            if (ofd.good()) {
-                ofd << outStr;
-                ofd.close();
+            /* stage 2: walks the index and assigns the values to the context
+             *
+             * @return False on a syntax error, the offset is available with error()
+             */
+            bool walk(JSONContext& context)
+            {
+                _next = 0;
+                _depth = 0;
+                return parseValue(&context);
             }
-        }
-        return outStr;
-    }
 
-    bool Config::config(const std::string& configPath)
-    {
-        // read content of the file
-        std::ifstream ifd(configPath, std::ios::in | std::ios::binary);
-        std::string configContent = "";
-        if (ifd) {
-            configContent = std::string((std::istreambuf_iterator<char>(ifd)), std::istreambuf_iterator<char>());
-        }
+            // offset of the first invalid byte
+            size_t error() const
+            {
+                return _error;
+            }
 
-        // extract extension
-        std::string extension = "";
-        size_t lastDot = configPath.find_last_of(".");
-        if (lastDot != std::string::npos) {
-            extension = configPath.substr(lastDot + 1);
-        }
+        private:
 
-        // load config according to extension
-        // default is json
-#ifdef MINICONF_JSON_SUPPORT
-        if (extension == "json" || extension == "JSON") {
-            return loadJSON(configContent);
-        } else if (extension == "csv" || extension == "CSV") {
-            return loadCSV(configContent);
-        } else {
-            return loadJSON(configContent);
-        }
-#else
-        return loadCSV(configContent);
-#endif
+            // nesting depth where parsing stops, so deeply nested input cannot exhaust the stack
+            static const size_t MAX_DEPTH = 1024;
 
-        return false;
-    }
+            bool fail(size_t offset)
+            {
+                _error = offset;
+                return false;
+            }
 
-    bool Config::loadCSV(const std::string& CSVStr)
-    {
-        std::stringstream ss(CSVStr);
-        bool success = true;
-        while (ss.good()){
-            std::string templine;
-            std::getline(ss, templine);
-            std::stringstream lss(templine);
-            if (templine.empty()){
-                continue;
+            // checks the character at the next index position, which is consumed if it matches
+            bool consume(char expected)
+            {
+                if (_next < _index.size() && _data[_index[_next]] == expected) {
+                    ++_next;
+                    return true;
+                }
+                return false;
             }
-            while (lss.good()){
-                std::string sflag;
-                std::string svalue;
-                std::getline(lss, sflag, ',');
-                std::getline(lss, svalue, ',');
-                if (svalue.empty()){
-                    continue;
-                    success = false;
+
+            size_t nextOffset() const
+            {
+                return (_next < _index.size()) ? _index[_next] : _end;
+            }
+
+            // parses a string at the index position of its opening quote, the content is in
+            // place unless it contains escapes
+            bool parseString(const char*& begin, const char*& end, std::string& scratch)
+            {
+                // the closing quote is the next position, unless the string is not terminated
+                size_t open = _index[_next - 1];
+                if (_next >= _index.size() || _data[_index[_next]] != '"') {
+                    return fail(std::max(open, _end));
                 }
-                // check if options exists
-                if (findOption(sflag)){
-                    // parse the default data type
-                    _optionValues[sflag] = parseValue(svalue.c_str(), _options[sflag].type());
-                    log(LogLevel::INFO, std::string(sflag), "value is loaded from config");
-                } else {
-                    // parse string when the flag does not exist in the original configuration
-                    _optionValues[sflag] = parseValue(svalue.c_str(), Value::DataType::STRING);
-                    log(LogLevel::INFO, std::string(sflag), "value is not defined in config, parsed as a string value");
+                size_t close = _index[_next++];
+                begin = _data + open + 1;
+                end = _data + close;
+                if (memchr(begin, '\\', static_cast<size_t>(end - begin)) != nullptr) {
+                    if (!unescapeJSON(begin, end, scratch)) {
+                        return fail(open);
+                    }
+                    begin = scratch.data();
+                    end = scratch.data() + scratch.size();
                 }
+                return true;
             }
-        }
-        return success;
-    }
 
-#ifdef MINICONF_JSON_SUPPORT
-    bool Config::getJSONValue(const picojson::value *v, const std::string& flag){
-        bool success = true;
-        if (findOption(flag)){
-            Config::Option opt = _options[flag];
-            if (opt.type() == Value::DataType::INT && v->is<double>()){
-                _optionValues[flag] = static_cast<int>(v->get<double>());
-            } else if (opt.type() == Value::DataType::NUMBER && v->is<double>()) {
-                _optionValues[flag] = v->get<double>();
-            } else if (opt.type() == Value::DataType::BOOL && v->is<bool>()) {
-                _optionValues[flag] = v->get<bool>();
-            } else if (opt.type() == Value::DataType::STRING && v->is<std::string>()) {
-                _optionValues[flag] = v->get<std::string>();
-            } else {
-                log(LogLevel::WARNING, flag, "Unable to parse the option from config file, flag = " + flag);
-                success = false;
+            // parses a value, the values of a null context are validated and skipped
+            bool parseValue(JSONContext* context)
+            {
+                if (_next >= _index.size()) {
+                    return fail(_end);
+                }
+                size_t offset = _index[_next++];
+                switch (_data[offset]) {
+                    case '{':
+                        return parseObject(context, offset);
+                    case '[':
+                        return parseArray(context, offset);
+                    case '"': {
+                        const char* begin = nullptr;
+                        const char* end = nullptr;
+                        if (!parseString(begin, end, _string)) {
+                            return false;
+                        }
+                        return (context == nullptr || context->set_string(begin, static_cast<size_t>(end - begin))) || fail(offset);
+                    }
+                    case '}': case ']': case ':': case ',':
+                        return fail(offset);
+                    default:
+                        return parseScalar(context, offset);
+                }
             }
-        }
-            // stray options
-        else
-        {
-            if (v->is<double>()){
-                _optionValues[flag] = v->get<double>();
+
+            bool parseScalar(JSONContext* context, size_t offset)
+            {
+                const char* begin = _data + offset;
+                const char* end = begin;
+                const char* limit = _data + _end;
+                while (end != limit && *end != ' ' && *end != '\t' && *end != '\n' && *end != '\r' && *end != ',' &&
+                        *end != '}' && *end != ']' && *end != ':' && *end != '"' && *end != '[' && *end != '{') {
+                    ++end;
+                }
+                // like picojson, the content following a root value is ignored
+                if (_depth == 0) {
+                    end = begin + std::min<size_t>(static_cast<size_t>(end - begin), scalarLength(begin, end));
+                }
+                bool accepted = true;
+                if (equals(begin, end, "true")) {
+                    accepted = (context == nullptr || context->set_bool(true));
+                } else if (equals(begin, end, "false")) {
+                    accepted = (context == nullptr || context->set_bool(false));
+                } else if (equals(begin, end, "null")) {
+                    accepted = (context == nullptr || context->set_null());
+                } else {
+                    // picojson accepts any token of number characters which starts with a digit or '-'
+                    // and is a complete number
+                    if (begin == end || (*begin != '-' && (*begin < '0' || *begin > '9')) || scalarLength(begin, end) != static_cast<size_t>(end - begin)) {
+                        return fail(offset);
+                    }
+                    Value number;
+                    accepted = (context != nullptr) ? context->parse_number(begin, end) : parseJSONNumber(begin, end, number);
+                }
+                return accepted || fail(offset);
             }
-            else if (v->is<bool>()) {
-                _optionValues[flag] = v->get<bool>();
-            } else if (v->is<std::string>()) {
-                _optionValues[flag] = v->get<std::string>();
-            } else {
-                log(LogLevel::WARNING, flag, "Unable to parse the option from config file.");
-                success = false;
+
+            // length of the literal or the run of number characters at the beginning of a token
+            static size_t scalarLength(const char* begin, const char* end)
+            {
+                for (const char* literal : { "true", "false", "null" }) {
+                    size_t length = strlen(literal);
+                    if (static_cast<size_t>(end - begin) >= length && memcmp(begin, literal, length) == 0) {
+                        return length;
+                    }
+                }
+                const char* c = begin;
+                while (c != end && ((*c >= '0' && *c <= '9') || *c == '+' || *c == '-' || *c == '.' || *c == 'e' || *c == 'E')) {
+                    ++c;
+                }
+                return static_cast<size_t>(c - begin);
             }
-        }
-        return success;
-    }
 
-    bool Config::parseJSON(const picojson::value *v, const std::string& flag){
-        if (v->is<double>() || v->is<bool>() || v->is<std::string>()){
-            return getJSONValue(v, flag);
-        } else if (v->is<picojson::object>()){
-            bool success = true;
-            for (auto objItem: v->get<picojson::object>()){
-                success = success && parseJSON(&(objItem.second), flag + (flag.empty() ? "" : ".") + objItem.first);
+            bool parseArray(JSONContext* context, size_t offset)
+            {
+                if (++_depth > MAX_DEPTH || (context != nullptr && !context->parse_array_start())) {
+                    return fail(offset);
+                }
+                size_t count = 0;
+                if (!consume(']')) {
+                    do {
+                        JSONContext* item = (context != nullptr && !context->skipArrayItem()) ? context : nullptr;
+                        if (!parseValue(item)) {
+                            return false;
+                        }
+                        ++count;
+                    } while (consume(','));
+                    if (!consume(']')) {
+                        return fail(nextOffset());
+                    }
+                }
+                --_depth;
+                return context == nullptr || context->parse_array_stop(count) || fail(offset);
             }
-            return success;
-        } else if (v->is<picojson::array>()){
-            for (auto arrayItem : v->get<picojson::array>()){
-                // print array, not supported yet
+
+            bool parseObject(JSONContext* context, size_t offset)
+            {
+                if (++_depth > MAX_DEPTH || (context != nullptr && !context->parse_object_start())) {
+                    return fail(offset);
+                }
+                if (!consume('}')) {
+                    do {
+                        if (!consume('"')) {
+                            return fail(nextOffset());
+                        }
+                        const char* key = nullptr;
+                        const char* keyEnd = nullptr;
+                        if (!parseString(key, keyEnd, _key)) {
+                            return false;
+                        }
+                        if (!consume(':')) {
+                            return fail(nextOffset());
+                        }
+                        bool parsed = true;
+                        if (context != nullptr && !context->skipObjectItem()) {
+                            context->pushKey(key, static_cast<size_t>(keyEnd - key));
+                            parsed = parseValue(context);
+                            context->popKey();
+                        } else {
+                            parsed = parseValue(nullptr);
+                        }
+                        if (!parsed) {
+                            return false;
+                        }
+                    } while (consume(','));
+                    if (!consume('}')) {
+                        return fail(nextOffset());
+                    }
+                }
+                --_depth;
+                return true;
             }
-        } else {
-            log(LogLevel::WARNING, flag, "Unable to parse JSON, abort, flag = " + flag);
-            return false;
-        }
-        return false;
-    }
 
-    bool Config::loadJSON(const std::string& JSONStr)
+            // the input, and the end of the indexed part
+            const char* _data;
+            size_t _size;
+            size_t _end;
+
+            // offsets of the structural characters, quotes and scalar values
+            std::vector<uint32_t> _index;
+
+            // next position in _index
+            size_t _next;
+
+            // nesting depth of arrays and objects
+            size_t _depth;
+
+            // offset of the first error
+            size_t _error;
+
+            // buffers for keys and strings with escapes
+            std::string _key;
+            std::string _string;
+    };
+
+    const size_t Config::StructuralJSON::MAX_DEPTH;
+
+    bool Config::loadJSON(Layer& values, const char* JSONData, size_t size, const std::string& section)
     {
-        picojson::value json;
-        picojson::parse(json, JSONStr);
-        return parseJSON(&json, "");
+        JSONContext context(this, values, section);
+        // offsets in the structural index are 32 bits wide
+        if (_jsonParser != JSONParser::PICOJSON && size < std::numeric_limits<uint32_t>::max()) {
+            StructuralJSON parser(JSONData, size);
+            parser.index(selectClassifier(_jsonParser));
+            if (!parser.walk(context)) {
+                // the same message as picojson, with the line of the error and the rest of the line
+                size_t error = std::min(parser.error(), size);
+                const char* lineEnd = static_cast<const char*>(memchr(JSONData + error, '\n', size - error));
+                char line[64];
+                snprintf(line, sizeof(line), "syntax error at line %d near: ",
+                        static_cast<int>(std::count(JSONData, JSONData + error, '\n') + 1));
+                std::string err(line);
+                for (const char* c = JSONData + error; c != (lineEnd != nullptr ? lineEnd : JSONData + size); ++c) {
+                    if (static_cast<unsigned char>(*c) >= ' ') {
+                        err.push_back(*c);
+                    }
+                }
+                log(values, LogLevel::WARNING, "", "Unable to parse JSON, " + err);
+                values.malformed = true;
+                return false;
+            }
+            return context.success();
+        }
+        std::string err;
+        picojson::_parse(context, JSONData, JSONData + size, &err);
+        if (!err.empty()) {
+            log(values, LogLevel::WARNING, "", "Unable to parse JSON, " + err);
+            values.malformed = true;
+            return false;
+        }
+        return context.success();
     }
 #endif
 
@@ -32,24 +32,26 @@
 #define MINICONF_JSON_SUPPORT
 
 #include <string>
+#include <cstdint>
 #include <cstring>
 #include <sstream>
 #include <fstream>
 #include <map>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <vector>
 
-#ifdef MINICONF_JSON_SUPPORT
-#include "picojson.h"
-#endif
-
 namespace miniconf
 {
 
     /* A flexible container for multiple data type
      *
-     * miniconf::Value is a flexible container for int, double, bool and char array. The 
-     * actual value is stored in a buffer declared during assignment. An extra "unknown"
-     * type is also defined for empty, or invalid value. 
+     * miniconf::Value is a flexible container for int, int64_t, double, bool and char array, and
+     * for arrays of them (except int64_t). The actual value is stored in a tagged union: scalars and short strings
+     * live inline in the object, only strings longer than INLINE_CAPACITY and arrays are
+     * stored in a heap buffer. The elements of an array are stored contiguously in one buffer.
+     * An extra "unknown" type is also defined for empty, or invalid value. 
      */
     class Value
     {
@@ -59,11 +61,23 @@ namespace miniconf
             enum class DataType {
                 UNKNOWN,
                 INT,
+                INT64,
                 NUMBER,
                 BOOL,
-                STRING
+                STRING,
+                INT_ARRAY,
+                NUMBER_ARRAY,
+                BOOL_ARRAY,
+                STRING_ARRAY
             };
 
+            /* A read-only view of the elements of an array value
+             *
+             * T is int, double, bool or const char* (for string arrays). The view points into
+             * the buffer of the value, it is invalidated when the value is modified.
+             */
+            template <typename T> class Array;
+
             /* Default constructors and assignments for Value, "unknown" type is assigned
              * to the instnace. It is suggested to use other constructor to assign valid
              * value when the instance is instantiated.
@@ -87,6 +101,9 @@ namespace miniconf
 
             // Constructs a Value instance from an integer 
             explicit Value(const int& other);
+
+            // Constructs a Value instance from a 64-bit integer
+            explicit Value(const int64_t& other);
             
             // Constructs a Value instance from a floating point
             explicit Value(const double& other);
@@ -99,9 +116,21 @@ namespace miniconf
             
             // Constructs a Value instance from a std::string
             explicit Value(const std::string& other);
+
+            // Constructs a string Value instance from a character range which needs not be null-terminated
+            Value(const char* other, size_t length);
+
+            // Constructs an array Value instance from a std::vector
+            explicit Value(const std::vector<int>& other);
+            explicit Value(const std::vector<double>& other);
+            explicit Value(const std::vector<bool>& other);
+            explicit Value(const std::vector<std::string>& other);
            
             // Assigns an integer to a Value instance
             Value& operator=(const int& other);
+
+            // Assigns a 64-bit integer to a Value instance
+            Value& operator=(const int64_t& other);
             
             // Assigns a floating point to a Value instance
             Value& operator=(const double& other);
@@ -114,10 +143,19 @@ namespace miniconf
             
             // Assigns a std::string to a Value instance
             Value& operator=(const std::string& other);
+
+            // Assigns a std::vector to a Value instance
+            Value& operator=(const std::vector<int>& other);
+            Value& operator=(const std::vector<double>& other);
+            Value& operator=(const std::vector<bool>& other);
+            Value& operator=(const std::vector<std::string>& other);
            
             // Casts a Value to an integer
             explicit operator int() const;
 
+            // Casts a Value to a 64-bit integer
+            explicit operator int64_t() const;
+
             // Casts a Value to a floating point number
             explicit operator double() const;
 
@@ -132,6 +170,9 @@ namespace miniconf
            
             // Explicitly gets an integer from a Value instance
             int getInt() const;
+
+            // Explicitly gets a 64-bit integer from a Value instance
+            int64_t getInt64() const;
             
             // Explicitly gets a floating point number from a Value instance
             double getNumber() const;
@@ -142,43 +183,206 @@ namespace miniconf
             // Explicitly gets a char array from a Value instance
             char* getCharArray() const;
 
-            // Explicitly gets a std::string from a Value instance
+            // Explicitly gets a std::string from a Value instance, other types are formatted by print()
             std::string getString() const;
 
+            // Explicitly gets the elements of an array, an empty array is returned on type mismatch
+            Array<int> getIntArray() const;
+            Array<double> getNumberArray() const;
+            Array<bool> getBooleanArray() const;
+            Array<const char*> getStringArray() const;
+
             // Serializes the value to a string
-            std::string print();
+            std::string print() const;
 
             // Serializes the data type of the current value to a string, mainly for debugging purpose
             std::string printType();
 
             // Gets the data type of the current value
-            DataType type();
+            DataType type() const;
+
+            // Gets the length of a string value, excluding the terminating null, or the number of elements of an array
+            size_t size() const;
+
+            // Checks if the value is an array
+            bool isArray() const;
+
+            // Gets the array type with elements of a scalar type, or the element type of an array type
+            static DataType arrayType(DataType elementType);
+            static DataType elementType(DataType arrayType);
 
             // Checks if the value is empty (unknown)
-            bool isEmpty();
+            bool isEmpty() const;
 
             // Generates an unknown (empty) Value object
             static Value unknown();
 
+            /* Reads the value as T without any type check
+             *
+             * T is one of int, int64_t, double, bool, const char*, std::string or an Array. This is a 
+             * single load from the storage, the caller is responsible for checking type() first.
+             * Unlike getCharArray() and getString(), strings are not checked for their type either.
+             */
+            template <typename T> T as() const;
+
+            // Gets the DataType corresponding to the C++ type T
+            template <typename T> static DataType typeOf();
+
+            // Checks if two values have the same type and content, numbers are compared bitwise
+            bool operator==(const Value& other) const;
+            bool operator!=(const Value& other) const;
+
+            // Maximum string length (excluding the terminating null) stored without heap allocation
+            static const size_t INLINE_CAPACITY = 22;
+
         private:
 
-            // Moves value data from a pointer
-            Value& moveData(char*& src, const size_t size, const DataType type);
+            // Takes over the storage of another value, leaving it unknown
+            Value& moveData(Value& other);
 
-            // Copies value data from a pointer
-            Value& copyData(const char* src, const size_t size, const DataType& type);
+            // Copies a string into the inline buffer or a new heap buffer
+            Value& copyString(const char* src, const size_t size);
 
-            // Clears allocated value data
+            // Allocates the buffer of an array, the value becomes an array of "count" elements
+            char* allocateArray(DataType type, size_t count, size_t bytes);
+
+            // Copies the buffer of another array
+            Value& copyArray(const Value& other);
+
+            // Gets the first element of an array
+            const char* arrayData() const;
+
+            // Gets the characters of a string, inline or on the heap depending on its length
+            const char* stringData() const { return (_size > INLINE_CAPACITY) ? _heap : _inline; }
+
+            // Clears allocated value data, the value becomes unknown
             void clearData();
 
+            // Checks if the value is stored in a heap buffer
+            bool isHeap() const;
+
             // It stores the data type of the current value
             DataType _type;
 
-            // Number of bytes allocated to the buffer
+            // Length of the string value or number of array elements, unused for scalar values
             size_t _size;
 
-            // The pointer to the value buffer
-            char* _data;
+            // The value storage, only one member is active according to _type
+            union {
+                int _int;
+                int64_t _int64;
+                double _number;
+                bool _bool;
+                char* _heap;
+                char _inline[INLINE_CAPACITY + 1];
+            };
+    };
+
+    template <typename T>
+    class Value::Array
+    {
+        public:
+
+            Array() : _data(nullptr), _size(0) {}
+
+            const T* data() const { return _data; }
+            size_t size() const { return _size; }
+            bool empty() const { return _size == 0; }
+
+            const T& operator[](size_t i) const { return _data[i]; }
+            const T* begin() const { return _data; }
+            const T* end() const { return _data + _size; }
+
+        private:
+
+            friend class Value;
+
+            Array(const T* data, size_t size) : _data(data), _size(size) {}
+
+            const T* _data;
+            size_t _size;
+    };
+
+    /* An immutable copy of the option values published by a Config object
+     *
+     * Snapshots are created by Config::publish() and read through Config::acquire(), which
+     * never blocks or takes a lock, so worker threads can read the configuration while
+     * another thread reloads it. A snapshot is pinned by its Guard, and it is released by
+     * the Config object once no guard of any thread can refer to it anymore.
+     */
+    class ConfigSnapshot
+    {
+        public:
+
+            /* Pins a snapshot while it is being read
+             *
+             * A guard must be destroyed by the thread which acquired it, and before the
+             * Config object it is acquired from. 
+             */
+            class Guard;
+
+            // Finds the value of a flag, nullptr if the value is not defined
+            const Value* find(const std::string& flag) const;
+
+            // Checks if the value of a flag is defined
+            bool contains(const std::string& flag) const;
+
+            /* Accesses the value of a flag
+             *
+             * If the value does not exist, std::out_of_range exception is thrown
+             */
+            const Value& operator[](const std::string& flag) const;
+
+            // Number of values in the snapshot
+            size_t size() const;
+
+            // Version of the snapshot, incremented by every Config::publish(), 0 if nothing is published
+            unsigned long long version() const;
+
+        private:
+
+            friend class Config;
+
+            // Per-thread reader state, defined in miniconf.cpp
+            struct Reader;
+
+            ConfigSnapshot();
+            ConfigSnapshot(const ConfigSnapshot&);
+            ConfigSnapshot& operator=(const ConfigSnapshot&);
+
+            // flags and values, sorted by flag, the flags are interned by the Config object
+            std::vector<const std::string*> _flags;
+            std::vector<size_t> _hashes;
+            std::vector<Value> _values;
+
+            // open-addressing hash table, a bucket stores (index + 1), or 0 when empty
+            std::vector<size_t> _index;
+
+            unsigned long long _version;
+    };
+
+    class ConfigSnapshot::Guard
+    {
+        public:
+
+            Guard(Guard&& other);
+
+            // Unpins the snapshot
+            ~Guard();
+
+            const ConfigSnapshot& operator*() const { return *_snapshot; }
+            const ConfigSnapshot* operator->() const { return _snapshot; }
+
+        private:
+
+            friend class Config;
+
+            Guard(Reader* reader, const ConfigSnapshot* snapshot);
+            Guard(const Guard&);
+            Guard& operator=(const Guard&);
+
+            Reader* _reader;
+            const ConfigSnapshot* _snapshot;
     };
 
     /*
@@ -227,18 +431,65 @@ namespace miniconf
              *
              * User can either serialize the current configuration, or 
              * write one config file manually using external editors.
+             * BINARY is a snapshot of the option schema and values which
+             * is loaded by config() without parsing, it is not meant to be edited.
              */
 #ifdef MINICONF_JSON_SUPPORT
             enum class ExportFormat {
                 JSON,
-                CSV
+                CSV,
+                BINARY
             };
 #else
             enum class ExportFormat {
-                CSV
+                CSV,
+                BINARY
             };
 #endif
 
+#ifdef MINICONF_JSON_SUPPORT
+            /* Parser of JSON config files
+             *
+             * PICOJSON parses the JSON files with picojson. The other parsers build an index of
+             * the structural characters of the file in a first pass, with the instruction set
+             * given, and read the values from the index in a second pass, which is faster on
+             * large files. A choice unsupported by the CPU falls back to the next one.
+             * * PICOJSON - picojson, the default
+             * * AUTO - The structural parser with the widest instruction set supported by the CPU
+             * * AVX2 - The structural parser with AVX2
+             * * SSE2 - The structural parser with SSE2
+             * * SCALAR - The structural parser without SIMD instructions
+             */
+            enum class JSONParser {
+                PICOJSON,
+                AUTO,
+                AVX2,
+                SSE2,
+                SCALAR
+            };
+#endif
+
+            /* Sources of option values, in the order of precedence
+             *
+             * Every source is kept as a separate layer of values, an option value is taken
+             * from the layer with the highest precedence which provides it. Config files are
+             * one layer each, a file loaded later takes precedence over earlier ones.
+             * * NONE - The value is not provided by any source, e.g. assigned with operator[]
+             * * DEFAULT - Default value of the option, set by parse()
+             * * FILE - A config file loaded by config(), or by parse() with --config
+             * * ENVIRONMENT - An environment variable loaded by environment()
+             * * ARGUMENT - A command line argument parsed by parse()
+             * * OVERRIDE - A value set with overrideValue() or loadSection()
+             */
+            enum class Source {
+                NONE,
+                DEFAULT,
+                FILE,
+                ENVIRONMENT,
+                ARGUMENT,
+                OVERRIDE
+            };
+
             /* Option member class which describe the properties of a configuration option.
              * 
              * A complete configuration setting is composed of multiple options, 
@@ -251,6 +502,29 @@ namespace miniconf
              */
             class Option;
 
+            /* A typed, pre-resolved reference to an option value
+             *
+             * A handle is created by Config::handle<T>(flag). The flag lookup and the type
+             * check are done once when the handle is created, reading the value through
+             * the handle is then a single load without string comparison or allocation.
+             */
+            template <typename T> class Handle;
+
+            /* A non-owning view of a nested section, e.g. "part1"
+             *
+             * A view is created by Config::view(section) and resolves flags relative to the
+             * section, view["value1"] reads "part1.value1" without building the dotted flag. It
+             * is small enough to be passed by value, and stays valid during the lifetime of the
+             * Config object, values reloaded by config() or poll() are visible through it.
+             */
+            class View;
+
+            // Receives the flag and the new value of a changed option value
+            typedef std::function<void(const std::string& flag, const Value& value)> ChangeCallback;
+
+            // Receives the flags of the values changed by one update, in alphabetical order
+            typedef std::function<void(const std::vector<std::string>& flags)> BatchCallback;
+
             // Default constructor, no option is defined except the default "help" and "config"
             Config();
 
@@ -268,11 +542,51 @@ namespace miniconf
             // Creates a new configuration option, which is uniquely identified by its flag
             Config::Option& option(const std::string& flag);
 
+            /* Resolves an option value to a typed handle
+             *
+             * The returned handle is invalid (Handle::valid() is false) when the value does
+             * not exist or its data type does not match T. Values assigned later by parse(),
+             * config() or operator[] are visible through the handle, as long as the value is
+             * not removed and keeps the same data type. A handle stays valid during the
+             * lifetime of the Config object.
+             */
+            template <typename T> Config::Handle<T> handle(const std::string& flag);
+
+            /* Creates a view of a nested section
+             *
+             * The section needs not contain any value yet, an empty section is the whole
+             * configuration. 
+             */
+            Config::View view(const std::string& section);
+
             // Removes an option
             bool remove(const std::string& flag);
 
             // Checks if the option value is defined in the current configuration
             bool contains(const std::string& flag);
+
+            /* Subscribes to changes of option values
+             *
+             * The pattern is a flag, a dotted prefix followed by ".*" (e.g. "part2.*"), or "*" for
+             * all values. Changes are delivered in one batch when parse(), config() or a reload by
+             * poll() completes: the callback is invoked once with all matching flags whose value 
+             * differs from the value before the update, or not at all if none has changed. Values
+             * assigned through operator[] are not notified.
+             *
+             * @return An id to cancel the subscription with unsubscribe()
+             */
+            size_t subscribe(const std::string& pattern, BatchCallback callback);
+
+            // Cancels a subscription, returns false if the id is unknown
+            bool unsubscribe(size_t id);
+
+            /* Visits the option values of a nested section, e.g. "part2"
+             *
+             * The values are visited in the order of their path segments, an empty section visits
+             * all values. Finding the section is a single hash lookup, and only the values within
+             * the section are visited.
+             */
+            void forEach(const std::string& section, const std::function<void(const std::string& flag, Value& value)>& visitor);
             
             // Sets a short description of the current application.
             void description(const std::string& desc);
@@ -288,6 +602,11 @@ namespace miniconf
 
             // display the log message
             void verbose(bool value);
+
+#ifdef MINICONF_JSON_SUPPORT
+            // Sets the parser of JSON config files
+            void jsonParser(JSONParser parser);
+#endif
             
             /*Checks config format design and reports errors if necessary
              *
@@ -311,7 +630,9 @@ namespace miniconf
 
             /* Accesses the configuration value
              *
-             * If the configuration value does not exist, an empty Value object is returned. 
+             * If the configuration value does not exist, an empty Value object is returned.
+             * A value modified through the reference keeps its source, and is replaced when
+             * the source providing the flag is loaded again.
              */
             Value& operator[](const std::string& flag);
 
@@ -322,17 +643,90 @@ namespace miniconf
             Value const& operator[](const std::string& flag) const;
 
             /* Load the configuration settings via a config file
-             * 
+             *
              * This function loads a config file, if the config file has been specified in
              * command line arguments, this will be called automatically in "parse()" function.
+             * On POSIX systems regular files are memory mapped and parsed in place, pipes and
+             * special files are read into a buffer. The parse log tells which path was taken.
+             * Binary snapshots are recognized by their header regardless of the extension, and
+             * are read in place: an entry is loaded the first time its flag is looked up. The
+             * file must not be changed in place while it is attached, replace it by a rename.
+             *
+             * Each file is a separate source layer. Loading a file again replaces the values
+             * of its layer only, values which are no longer in the file fall back to the other
+             * sources, and only the values provided by the file are updated. A file which cannot
+             * be parsed, e.g. with a syntax error, changes no value. A value which does not match
+             * the type of its option, or a null, is skipped with a warning, the other values of
+             * the file are loaded and false is returned. A null of a flag which is not an option
+             * is skipped with a warning only.
+             *
+             * A directory is loaded with configDirectory().
              *
              * @configPath the input configuration file path
              */
             bool config(const std::string& configPath);
 
+            /* Loads the config files of a directory, e.g. "conf.d"
+             *
+             * The JSON, CSV and binary files in the directory are parsed concurrently, each into
+             * its own table, and merged in the order of their file names, so a value in a later
+             * file overwrites the value in an earlier one regardless of the number of threads.
+             * The directory is one source layer. Hidden files are skipped. The directory fails
+             * like a single file loaded by config(): a file which cannot be read or parsed leaves
+             * the values of the directory unchanged, values which are rejected are skipped.
+             *
+             * @directoryPath the directory containing the config files
+             * @threads the number of threads parsing the files, 0 uses one thread per core
+             * @return False if the directory or one of the files cannot be loaded, or a value is rejected
+             */
+            bool configDirectory(const std::string& directoryPath, unsigned threads = 0);
+
+            /* Loads the option values from environment variables
+             *
+             * The environment is scanned once, variables starting with the prefix are mapped to
+             * flags by removing the prefix, replacing "__" with "." and ignoring the case, e.g.
+             * MYAPP_PART2__SUBPART1__VALUE1 sets "part2.subpart1.value1" for the prefix "MYAPP".
+             * Variables which do not match an option are ignored. The values are parsed like
+             * command line arguments, and are a source layer between the config files and the
+             * command line arguments, which is kept when parse() is called afterwards.
+             *
+             * @prefix the prefix of the variables, a trailing '_' is added if missing
+             * @env a null-terminated array of "NAME=value" strings, the process environment by default
+             * @return False if a value cannot be parsed
+             */
+            bool environment(const std::string& prefix, char** env = nullptr);
+
+            /* Overrides an option value at runtime
+             *
+             * The override takes precedence over all other sources, and is kept when a config
+             * file is reloaded or the arguments are parsed again. Subscribers are notified like
+             * after config().
+             *
+             * @return False if the value does not match the data type of the option
+             */
+            bool overrideValue(const std::string& flag, const Value& value);
+
+            // Removes the override of an option value, the value falls back to the other sources
+            bool clearOverride(const std::string& flag);
+
+            // Gets the source of the current value of a flag
+            Source source(const std::string& flag) const;
+
+            /* Gets the name of the source of the current value of a flag
+             *
+             * This is the path of a config file, the prefix of environment variables, or "default",
+             * "arguments" and "override" for the other sources. An empty string is returned if the
+             * value has no source.
+             */
+            const std::string& sourceName(const std::string& flag) const;
+
             /* Serializes the current configuration
              *
-             * Currently JSON and CSV are supported.
+             * Currently JSON, CSV and BINARY are supported, the format is chosen by the
+             * extension of the file path (".json", ".csv" or ".bin"). If a file path is given,
+             * the output is streamed to the file and an empty string is returned; otherwise
+             * the serialized configuration is returned. Attached binary snapshots are loaded
+             * and unmapped before the file is opened, so it may be the snapshot just loaded.
              */
 #ifdef MINICONF_JSON_SUPPORT
             std::string serialize(const std::string& serializeFilePath = "", ExportFormat format = ExportFormat::JSON, bool pretty = true);
@@ -340,12 +734,113 @@ namespace miniconf
             std::string serialize(const std::string& serializeFilePath = "", ExportFormat format = ExportFormat::CSV, bool pretty = true);
 #endif
 
+            /* Serializes the current configuration to an open file
+             *
+             * The output is streamed through a fixed-size buffer, so the memory used does
+             * not depend on the size of the configuration. 
+             *
+             * @return False if writing to the file failed
+             */
+#ifdef MINICONF_JSON_SUPPORT
+            bool serialize(FILE* fd, ExportFormat format = ExportFormat::JSON, bool pretty = true);
+#else
+            bool serialize(FILE* fd, ExportFormat format = ExportFormat::CSV, bool pretty = true);
+#endif
+
+            /* Serializes the values of a nested section, e.g. "part2"
+             *
+             * The flags are written relative to the section, so the output can be loaded into any
+             * section with loadSection(). Only JSON and CSV are supported.
+             */
+#ifdef MINICONF_JSON_SUPPORT
+            std::string serializeSection(const std::string& section, ExportFormat format = ExportFormat::JSON, bool pretty = true);
+#else
+            std::string serializeSection(const std::string& section, ExportFormat format = ExportFormat::CSV, bool pretty = true);
+#endif
+
+            /* Loads JSON or CSV content into a nested section
+             *
+             * The flags in the content are relative to the section, e.g. "value1" is loaded into
+             * "part2.value1" for the section "part2". The values are overrides, see overrideValue().
+             * Subscribers are notified like after config(), content which cannot be parsed loads
+             * no value.
+             */
+#ifdef MINICONF_JSON_SUPPORT
+            bool loadSection(const std::string& section, const std::string& content, ExportFormat format = ExportFormat::JSON);
+#else
+            bool loadSection(const std::string& section, const std::string& content, ExportFormat format = ExportFormat::CSV);
+#endif
+
+            /* Writes a durable snapshot of the current configuration
+             *
+             * The output is written to a temporary file in the directory of the target,
+             * flushed to disk and renamed over the target, the directory is synced afterwards.
+             * A crash at any point leaves either the previous or the new file, never a truncated one.
+             * The permissions of an existing target are preserved.
+             *
+             * @return False if the snapshot could not be written, the target is then left untouched;
+             * or if the directory could not be synced after the rename, the new file is then in
+             * place but may not survive a crash
+             */
+#ifdef MINICONF_JSON_SUPPORT
+            bool snapshot(const std::string& snapshotFilePath, ExportFormat format = ExportFormat::JSON, bool pretty = true);
+#else
+            bool snapshot(const std::string& snapshotFilePath, ExportFormat format = ExportFormat::CSV, bool pretty = true);
+#endif
+
             // Enables automatically generated help message (--help/-h)
             void enableHelp(bool enabled = true);
 
             // Ennables setting via external config file (--config/-cfg)
             void enableConfig(bool enabled = true);
 
+            /* Watches a config file and reloads it when its content changes
+             *
+             * The file defaults to the last file loaded by config(). On Linux the directory of
+             * the file is watched with inotify, so a file replaced by rename() (e.g. by snapshot())
+             * is detected as well; on other systems the size and modification time of the file are
+             * compared at every poll(). Nothing is reloaded until poll() is called.
+             *
+             * @callback invoked by poll() once for every value which differs after a reload
+             * @configPath the config file to watch
+             * @return False if there is no config file to watch
+             */
+            bool watch(ChangeCallback callback, const std::string& configPath = "");
+
+            // Stops watching the config file
+            void unwatch();
+
+            /* Checks the watched config file and reloads it if it has changed
+             *
+             * Waits up to timeoutMs milliseconds for a change, 0 returns immediately. The file is
+             * only parsed again if its size or modification time differ and its content hash has
+             * changed since the last load. A reload which fails to parse leaves all values unchanged,
+             * rejected values are skipped like in config().
+             * Only the layer of the file is replaced, values missing from the new file fall back to
+             * the other sources. poll() modifies the Config object, it must be called by the thread
+             * which owns it.
+             *
+             * @return True if the file has been reloaded and at least one value has changed
+             */
+            bool poll(int timeoutMs = 0);
+
+            /* Publishes the current option values as an immutable snapshot
+             *
+             * The new snapshot replaces the previous one atomically, readers which still hold a
+             * guard on an older snapshot keep reading it. Old snapshots are released by later 
+             * calls once no reader can refer to them. Only the values are copied, publish() must
+             * be called by the thread which modifies the Config object.
+             */
+            void publish();
+
+            /* Pins the latest published snapshot
+             *
+             * This is safe to call from any thread, concurrently with publish(). It never blocks
+             * and takes no lock, the first call of a thread registers the thread with the Config
+             * object. An empty snapshot is returned if nothing has been published yet.
+             */
+            ConfigSnapshot::Guard acquire() const;
+
             // Prints usage of this program's configuration options
             void usage(FILE* fd = stdout);
 
@@ -375,8 +870,8 @@ namespace miniconf
             TokenType getTokenType(const char* token);
 
             // since long flag is the key for the option directory,
-            // this function transltes short flag to long flag
-            std::string translateShortflag(const std::string& shortflag);
+            // this function transltes short flag to the slot of the option, NO_SLOT if not found
+            size_t translateShortflag(const char* shortflag, size_t length) const;
 
             // search for options using token
             Option* getOption(const char* token, Config::TokenType tokenType);
@@ -386,29 +881,441 @@ namespace miniconf
 
             // parse a token into Value
             Value parseValue(const char* token, Value::DataType dataType);
+            Value parseValue(const char* begin, const char* end, Value::DataType dataType);
+
+            // the values of a source, see the source layers below
+            struct Layer;
 
 #ifdef MINICONF_JSON_SUPPORT
-            // load json config string
-            bool loadJSON(const std::string& JSONStr);
+            /* picojson parse context which assigns JSON values to a layer while
+             * they are parsed, no picojson DOM is built. Nested objects are flattened into
+             * dotted flags.
+             */
+            class JSONContext;
+
+            // two-stage parser which indexes the structural characters of a JSON buffer before
+            // reading the values, used unless the parser is PICOJSON
+            class StructuralJSON;
 
-            // parse a json value
-            bool parseJSON(const picojson::value *v, const std::string& flag); 
+            // load json config from a buffer into a layer, the flags are relative to a section
+            bool loadJSON(Layer& values, const char* JSONData, size_t size, const std::string& section = "");
 
-            // load a value from json
-            bool getJSONValue(const picojson::value *v, const std::string& flag); 
+            // assign a value loaded from json to a flag with a precomputed hash
+            bool assignJSONValue(Layer& values, const std::string& flag, size_t hash, Value&& value);
 #endif
 
-            // load csv config string
-            bool loadCSV(const std::string& CSVStr);
+            // load csv config from a buffer into a layer, the flags are relative to a section
+            bool loadCSV(Layer& values, const char* CSVData, size_t size, const std::string& section = "");
 
-            // internal function for adding log messages
+            // reader of a binary snapshot which verifies the blocks of the file as they are read
+            class BinaryReader;
+
+            // a binary snapshot attached to the layer of its file, defined in miniconf.cpp
+            struct MappedSnapshot;
+
+            // a config file of a directory, parsed by a worker thread into its own layer
+            struct DirectoryFragment;
+
+            // load all entries of a binary snapshot from a buffer into a layer without a slot
+            // table, the header is validated first
+            bool loadBinary(Layer& values, const char* binaryData, size_t size);
+
+            // loads the schema of a snapshot entry into its slot unless the program defines the
+            // option, and unpacks its value, UNKNOWN if the entry has none; false if the entry
+            // is corrupt or its value does not match the option type
+            bool loadBinaryEntry(BinaryReader& reader, size_t entry, size_t& slot, Value& value);
+
+            /* attaches the binary snapshot of a config file to the layer of the file
+             *
+             * Only the header and the block checksums are read, and the entries of the slots
+             * which exist already and of the options validate() acts on are loaded. Any other
+             * entry is loaded when its slot is added, the first time its flag is looked up,
+             * so the pages read depend on the flags used rather than on the size of the file.
+             */
+            bool attachBinary(const std::string& configPath, std::unique_ptr<MappedSnapshot>& mapped);
+
+            // detaches the binary snapshot of a layer, if any
+            void detachBinary(size_t layer);
+
+            // loads the entries of the attached snapshots for the flag of a new slot
+            void loadMappedSlot(size_t slot);
+
+            // loads all entries of the attached snapshots and detaches them, every walk over
+            // the slots calls this first
+            void loadMappedEntries();
+
+            // finds the slot of a flag, a flag of an attached snapshot is loaded into a new slot
+            size_t lookupSlot(const char* flag, size_t length);
+            size_t lookupSlot(const std::string& flag);
+
+            // load the content of a config file into a layer, the format is chosen by the header
+            // or the extension
+            bool load(Layer& values, const std::string& configPath, const char* data, size_t size);
+
+            // buffered output of the serializer, writing to a FILE* or a std::string
+            class Writer;
+
+            // write the option values in the given format
+            void writeFormat(Writer& out, ExportFormat format, bool pretty);
+
+            // write the option values of the section at a path node as CSV
+            void writeCSV(Writer& out, size_t root = 0);
+
+            // write the option schema and values as a binary snapshot
+            void writeBinary(Writer& out);
+
+#ifdef MINICONF_JSON_SUPPORT
+            // write the option values of the section at a path node as nested JSON objects
+            void writeJSON(Writer& out, bool pretty, size_t root = 0);
+
+            // write one value, arrays are indented at the given depth
+            void writeJSONValue(Writer& out, const Value& value, bool pretty, size_t depth);
+#endif
+
+            // internal function for adding log messages, nothing is allocated when the
+            // message is filtered by the log level
             void log(LogLevel logType, const std::string& token, const std::string& msg);
+            void log(LogLevel logType, const char* token, const char* msg);
+
+            // adds a log message of a loader, to the slot table of the layer if it has one
+            void log(Layer& values, LogLevel logType, const std::string& token, const std::string& msg);
+
+            /* Option store
+             *
+             * Options and option values share one flat store in struct-of-arrays layout. Every
+             * distinct flag gets a slot index the first time it is seen, the slot is never 
+             * released, so references to Option and Value objects stay valid during the 
+             * lifetime of the Config object. The store doubles as the interning table of the
+             * flags: each flag is stored once with its hash, at a fixed address, so options and
+             * published snapshots refer to it instead of copying it. Flags are resolved with an
+             * open-addressing hash index, and a slot permutation sorted by flag keeps print(),
+             * help() and serialize() in alphabetical order.
+             */
+
+            // slot index returned when a flag is not found
+            static const size_t NO_SLOT = static_cast<size_t>(-1);
+
+            // bit flags in _slotStates
+            enum SlotState {
+                SLOT_OPTION = 1,    // an option is defined in the slot
+                SLOT_VALUE = 2,     // a value is assigned to the slot
+                SLOT_RECORDED = 4,  // the previous value is recorded in _changes
+                SLOT_PENDING = 8    // the value is resolved again from the layers by resolve()
+            };
+
+            // value of a slot before its first assignment while changes are recorded
+            struct ChangeRecord {
+                size_t slot;
+                bool hadValue;
+                Value previous;
+            };
+
+            // finds the slot of a flag, NO_SLOT if the flag is not found
+            size_t findSlot(const char* flag, size_t length, size_t hash) const;
+            size_t findSlot(const char* flag, size_t length) const;
+            size_t findSlot(const std::string& flag) const;
+
+            // finds the slot of a flag, a new slot is created if the flag is not found
+            size_t acquireSlot(const char* flag, size_t length, size_t hash);
+            size_t acquireSlot(const char* flag, size_t length);
+            size_t acquireSlot(const std::string& flag);
+
+            /* marks a slot as assigned and returns its value for assignment
+             *
+             * While a source is loaded, the value is assigned to the layer being loaded instead.
+             */
+            Value& assignSlot(size_t slot);
+
+            // starts recording the previous values of assigned slots
+            void recordChanges();
+
+            /* stops recording changes
+             *
+             * If commit is true, the slots whose values differ from their recorded values are
+             * appended to "changed", otherwise the recorded values are restored.
+             */
+            void finishChanges(bool commit, std::vector<size_t>& changed);
+
+            // starts a batch of changes, batches may be nested
+            void beginBatch();
+
+            // ends a batch, the outermost batch notifies the subscribers and appends the changed
+            // slots to "changed" if given
+            void endBatch(std::vector<size_t>* changed = nullptr);
+
+            // notifies the subscribers of the changed slots
+            void notify(std::vector<size_t>& changed);
+
+            // the part of parse() which runs within a batch
+            bool parseArguments(int argc, char** argv);
+
+            // a subscription to the values matching a flag or a prefix
+            struct Subscription {
+                size_t id;
+                std::string prefix;     // flag, or prefix including the trailing '.'
+                bool exact;             // the prefix is a complete flag
+                ChangeCallback onValue; // per-value callback of Option::onChange()
+                BatchCallback onBatch;  // batch callback of subscribe()
+            };
+
+            // slots numbered by a layer of its own, for the layers loaded by the workers of
+            // configDirectory(), which only read the slot store of the Config
+            struct SlotTable {
+                std::vector<std::string> flags;     // slot -> flag
+                std::vector<size_t> flagHashes;
+                std::vector<size_t> index;          // hash index, (slot + 1) or 0 when empty
+                std::vector<std::string> log;       // log lines, moved to the log of the Config by the merge
+
+                // finds the slot of a flag, a new slot is added if not found
+                size_t acquire(const char* flag, size_t length, size_t hash);
+            };
+
+            /* Source layers
+             *
+             * The values of every source are kept in a separate layer, sparse over the slots. The
+             * loaders assign their values to a fresh layer, which then replaces (or is merged into)
+             * the layer of the source. Only the slots whose value can change, those provided by the
+             * layer before or after, unless a layer with higher precedence provides them, are marked
+             * pending; resolve() copies the winning value of each pending slot to _optionValues
+             * once, so the merged values are never rebuilt from all layers.
+             */
+            struct Layer {
+                Source source;
+                std::string name;           // path of a config file, or the name of the source
+                size_t rank;                // position in _layerOrder, higher ranks take precedence
+                std::vector<size_t> index;  // slot -> position in values, NO_SLOT if not provided
+                std::vector<size_t> slots;  // position -> slot
+                std::vector<Value> values;  // values provided by the layer
+                SlotTable* slotTable;       // own slots of the layer, nullptr for the slots of the Config
+                bool malformed;             // the loaded content could not be parsed to its end
+
+                Layer() : source(Source::NONE), rank(0), slotTable(nullptr), malformed(false) {}
+
+                // finds the value of a slot, nullptr if the layer does not provide it
+                const Value* find(size_t slot) const;
+
+                // returns the value of a slot for assignment, it is added if not provided yet
+                Value& assign(size_t slot);
+
+                // removes the value of a slot, returns false if the layer does not provide it
+                bool erase(size_t slot);
+
+                // removes all values and resets malformed, the buffers are kept for the next load
+                void clear();
+            };
+
+            // finds the layer of a source, a new layer is added if not found
+            size_t acquireLayer(Source source, const std::string& name);
+
+            // replaces the values of a layer with the values loaded into "values", which are
+            // moved into the buffers of the layer and cleared
+            void replaceLayer(size_t layer, Layer& values);
+
+            // merges the values loaded into "values" into a layer, existing values are replaced
+            void mergeLayer(size_t layer, Layer& values);
+
+            // marks a slot provided by a layer as pending, unless a layer with higher precedence provides it
+            void markPending(size_t layer, size_t slot);
+
+            // assigns the pending slots from the layer with the highest precedence which provides them
+            void resolve();
+
+            // finds the slot of a loaded flag, in the slot table of the layer if it has one
+            size_t loadSlot(Layer& values, const char* flag, size_t length, size_t hash);
+
+            // gets the flag of a loaded slot
+            const std::string& loadedFlag(const Layer& values, size_t slot) const;
+
+            // gets the option defining the data type of a loaded value, nullptr for a stray value
+            const Option* loadedOption(const Layer& values, size_t slot) const;
+
+            // checks the state of a slot
+            bool hasOption(size_t slot) const;
+            bool hasValue(size_t slot) const;
+
+            // gets all slots sorted by flag
+            const std::vector<size_t>& sortedSlots();
+
+            // adds the short flag of the option in a slot to the short flag index
+            void indexShortflag(size_t slot);
+
+            // removes the short flag of the option in a slot from the short flag index
+            void unindexShortflag(size_t slot);
+
+            // checks if the short flag of the option in a slot is also used by other options
+            bool sharesShortflag(size_t slot) const;
+
+            // updates the format issue counters when the diagnostics of an option change
+            void countDiagnostics(unsigned char before, unsigned char after);
+
+            /* Path trie
+             *
+             * Every distinct dotted prefix of the flags, e.g. "part2" and "part2.subpart1" for 
+             * "part2.subpart1.value1", is a node. Node 0 is the root (the empty prefix). Nodes
+             * refer to the interned flags instead of copying their prefix, and are indexed by
+             * the hash of their prefix, so a section is found with a single hash lookup. The
+             * children of a node are linked in the order of their last segment (children added
+             * out of order are sorted lazily), a preorder walk visits the flags in the nesting
+             * order of a JSON document. Like slots, nodes are
+             * never released.
+             */
+            struct PathNode {
+                const char* path;       // the dotted prefix, points into an interned flag
+                size_t length;          // length of the prefix
+                size_t segment;         // offset of the last segment within the prefix
+                size_t name;            // interned last segment, see _segments
+                size_t hash;            // hash of the prefix
+                size_t parent;          // parent node, NO_SLOT for the root
+                size_t firstChild;      // first child, NO_SLOT if the node is a leaf
+                size_t lastChild;       // last child, NO_SLOT if the node is a leaf
+                size_t nextSibling;     // next child of the parent, NO_SLOT if it is the last one
+                size_t slot;            // slot of the flag equal to the prefix, or NO_SLOT
+                bool unsorted;          // children have been added out of order since the last sortNodes(),
+                                        // the node is listed in _unsortedNodes
+            };
+
+            // finds the node of a dotted prefix, NO_SLOT if it is not a prefix of any flag
+            size_t findNode(const char* path, size_t length, size_t hash) const;
+            size_t findNode(const std::string& path) const;
+
+            // finds the child of a node by its segment, NO_SLOT if not found
+            size_t findChild(size_t node, const char* segment, size_t length) const;
+
+            // finds an interned path segment, NO_SLOT if no flag has the segment
+            size_t findSegment(const char* segment, size_t length, size_t hash) const;
+
+            // interns a path segment, returns its index in _segments
+            size_t internSegment(const char* segment, size_t length);
+
+            // creates a view of a section which has no path node yet
+            View missingView(const std::string& section);
+
+            // adds the prefixes of the flag of a new slot to the trie
+            void indexPath(size_t slot);
+
+            /* sorts the children of the nodes which have been added out of order
+             *
+             * Children are appended to their parent when a flag is added. Inserting them in
+             * order instead is quadratic for wide sections whose flags are not added in
+             * lexicographic order, e.g. value0 .. value19999 loaded from a file. Every walk of
+             * the trie calls this first, so a sibling list is sorted once per batch of additions.
+             */
+            void sortNodes();
+
+            // gets the next node of a preorder walk of the subtree at root, NO_SLOT at the end
+            size_t nextNode(size_t node, size_t root) const;
+
+            // finds the slot of a flag relative to the prefix of a node, NO_SLOT if not found
+            size_t findSlot(size_t node, const char* key, size_t length) const;
+
+            // slot -> interned flag, a deque so the strings never move
+            std::deque<std::string> _flags;
+
+            // slot -> hash of flag
+            std::vector<size_t> _flagHashes;
+
+            // slot -> combination of SlotState bits
+            std::vector<unsigned char> _slotStates;
 
-            // this map stores configuration format design, e.g. flag, default values.
-            std::map<std::string, Option> _options;
+            // slot -> configuration format design, e.g. flag, default values.
+            std::deque<Option> _options;
 
-            // this map stores the values parsed form user input
-            std::map<std::string, Value> _optionValues;
+            // slot -> values parsed from user input, merged from the layers
+            std::deque<Value> _optionValues;
+
+            // slot -> layer providing the value, or NO_SLOT
+            std::vector<size_t> _slotLayers;
+
+            // open-addressing hash table, a bucket stores (slot + 1), or 0 when empty
+            std::vector<size_t> _slotIndex;
+
+            // slots sorted by flag, rebuilt lazily when new slots are added
+            std::vector<size_t> _sortedSlots;
+
+            // nodes of the path trie
+            std::vector<PathNode> _nodes;
+
+            // nodes whose children are linked out of order
+            std::vector<size_t> _unsortedNodes;
+
+            // sections of views created before any flag within them, resolved when the flags are added
+            std::deque<std::string> _missingSections;
+
+            // open-addressing hash table of the nodes except the root, a bucket stores the node
+            // index, or 0 when empty
+            std::vector<size_t> _nodeIndex;
+
+            /* distinct path segments of all flags
+             *
+             * Every segment is stored once however many sections contain it, e.g. "enabled" of
+             * "camera.enabled" and "audio.enabled". The children of a node have distinct segments,
+             * so findChild() compares the interned segments of the nodes by index.
+             */
+            std::deque<std::string> _segments;
+
+            // segment -> hash of segment
+            std::vector<size_t> _segmentHashes;
+
+            // open-addressing hash table of segments, a bucket stores (segment + 1), or 0 when empty
+            std::vector<size_t> _segmentIndex;
+
+            // open-addressing hash table of short flags, a bucket stores (slot + 1) of the 
+            // first option registered with the short flag, or 0 when empty
+            std::vector<size_t> _shortflagIndex;
+
+            // number of short flags in _shortflagIndex
+            size_t _shortflagCount;
+
+            // slot -> next slot registered with the same short flag (a duplicate), or NO_SLOT
+            std::vector<size_t> _shortflagNext;
+
+            // number of options sharing a short flag with an earlier registered option
+            size_t _duplicateShortflags;
+
+            // binary snapshots attached to their file layers, in the order they were loaded
+            std::vector<std::unique_ptr<MappedSnapshot>> _mappedSnapshots;
+
+            // number of defined options with error / warning level format issues
+            size_t _formatErrors;
+            size_t _formatWarnings;
+
+            // source layers, a deque so the layers never move, layers are never released
+            std::deque<Layer> _layers;
+
+            // layers sorted by precedence, lowest first
+            std::vector<size_t> _layerOrder;
+
+            // layer receiving the values of assignSlot() while the defaults, the arguments or the
+            // environment are loaded, nullptr otherwise; config files are loaded into the layer
+            // passed to the loaders
+            Layer* _loading;
+
+            // layer the command line and default values are loaded into before they replace
+            // their layers, kept so a parse reuses its buffers
+            Layer _scratchLayer;
+
+            // slots to be resolved from the layers, marked with SLOT_PENDING
+            std::vector<size_t> _pendingSlots;
+
+#ifdef MINICONF_JSON_SUPPORT
+            // parser of JSON config files
+            JSONParser _jsonParser;
+#endif
+
+            // previous values of the slots assigned since recordChanges()
+            std::vector<ChangeRecord> _changes;
+
+            // switch for recording changes in assignSlot()
+            bool _recording;
+
+            // nesting depth of beginBatch() calls
+            unsigned _batchDepth;
+
+            // subscriptions in the order of registration
+            std::vector<Subscription> _subscriptions;
+
+            // id of the next subscription
+            size_t _nextSubscription;
 
             // this is a stack of log messages
             std::vector<std::string> _log;
@@ -431,6 +1338,17 @@ namespace miniconf
             // switch for enable loading configuration
             bool _loadConfig; 
 
+            // the last config file passed to config()
+            std::string _configPath;
+
+            // watched config file, defined in miniconf.cpp
+            class Watcher;
+            std::unique_ptr<Watcher> _watcher;
+
+            // published snapshots and their readers, shared with the threads reading them
+            class SnapshotDomain;
+            std::shared_ptr<SnapshotDomain> _snapshots;
+
     };
 
     /*
@@ -456,7 +1374,10 @@ namespace miniconf
             // Default destructor
             ~Option();
 
-            // Sets the flag of an option
+            /* Sets the flag of an option
+             *
+             * The flag of an option owned by a Config object identifies it, and cannot be changed.
+             */
             Config::Option& flag(const std::string& flag);
 
             // Sets the short flag of an option
@@ -470,6 +1391,9 @@ namespace miniconf
 
             // Sets the default value of an option from an integer
             Config::Option& defaultValue(const int& defaultValue);
+
+            // Sets the default value of an option from a 64-bit integer
+            Config::Option& defaultValue(const int64_t& defaultValue);
             
             // Sets the default value of an option from a floating point
             Config::Option& defaultValue(const double& defaultValue);
@@ -483,6 +1407,12 @@ namespace miniconf
             // Sets the default value of an option from a string
             Config::Option& defaultValue(const std::string& defaultValue);
 
+            // Sets the default value of an array option
+            Config::Option& defaultValue(const std::vector<int>& defaultValue);
+            Config::Option& defaultValue(const std::vector<double>& defaultValue);
+            Config::Option& defaultValue(const std::vector<bool>& defaultValue);
+            Config::Option& defaultValue(const std::vector<std::string>& defaultValue);
+
             // Makes an option to be required or optional
             Config::Option& required(const bool required);
 
@@ -492,8 +1422,16 @@ namespace miniconf
              */
             Config::Option& hidden(const bool hidden);
 
-            // Prints the flag of an option as a string
-            std::string flag();
+            /* Invokes a callback when the value of the option changes
+             *
+             * The callback receives the new value at most once per parse(), config() or reload,
+             * see Config::subscribe(). It has no effect on an option which is not owned by a
+             * Config object.
+             */
+            Config::Option& onChange(ChangeCallback callback);
+
+            // Gets the flag of an option
+            const std::string& flag() const;
 
             // Prints the shortflag of an option as a string
             std::string shortflag();
@@ -515,7 +1453,28 @@ namespace miniconf
 
         private:
 
-            // Flag of the option
+            friend class Config;
+
+            // Format issues of an option, cached in _diagnostics
+            enum FormatIssue {
+                NO_DEFAULT_VALUE = 1,       // error: optional argument without default value
+                NO_DESCRIPTION = 2,         // warning: no description text
+                NO_SHORTFLAG = 4            // warning: no short flag
+            };
+
+            // Checks if this option is owned by a Config object (and not a copy of one)
+            bool attached() const;
+
+            // Re-evaluates the cached format issues after a property has changed
+            void updateDiagnostics();
+
+            // The Config object owning this option, nullptr for a free-standing option
+            Config*         _config;
+
+            // Slot of this option in the owning Config object
+            size_t          _slot;
+
+            // Flag of a free-standing option, an owned option uses the flag interned by its Config
             std::string     _flag;          
             
             // Shortened flag of the option
@@ -533,14 +1492,148 @@ namespace miniconf
             // Option is hidden
             bool            _hidden;
 
+            // Combination of FormatIssue bits, kept up to date by the setters
+            unsigned char   _diagnostics;
+
+    };
+
+
+    template <typename T>
+    class Config::Handle
+    {
+        public:
+
+            // Creates an invalid handle, use Config::handle<T>(flag) to create a valid one
+            Handle() : _value(nullptr) {}
+
+            // Checks if the handle refers to a value
+            bool valid() const { return _value != nullptr; }
+
+            // Reads the current value, the type was checked once when the handle was created
+            T get() const { return _value->as<T>(); }
+
+            // Reads the current value
+            T operator*() const { return get(); }
+
+        private:
+
+            friend class Config;
+            friend class Config::View;
+
+            explicit Handle(const Value* value) : _value(value) {}
+
+            // The referenced value, owned by the Config object
+            const Value* _value;
+    };
+
+    class Config::View
+    {
+        public:
+
+            // Creates an invalid view, use Config::view(section) to create a valid one
+            View() : _config(nullptr), _node(0), _missing(NO_SLOT) {}
+
+            // Checks if the view refers to a section
+            bool valid() const { return _config != nullptr; }
+
+            // Gets the dotted prefix of the section
+            std::string section() const;
+
+            // Finds the value of a relative flag, nullptr if the value is not defined
+            const Value* find(const char* key) const;
+            const Value* find(const std::string& key) const;
+
+            // Checks if the value of a relative flag is defined
+            bool contains(const char* key) const;
+            bool contains(const std::string& key) const;
+
+            /* Accesses the value of a relative flag
+             *
+             * If the value does not exist, std::out_of_range exception is thrown
+             */
+            const Value& operator[](const char* key) const;
+            const Value& operator[](const std::string& key) const;
+
+            // Creates a view of a nested section relative to this one
+            View view(const std::string& section) const;
+
+            // Resolves a relative flag to a typed handle, see Config::handle()
+            template <typename T> Config::Handle<T> handle(const std::string& key) const;
+
+        private:
+
+            friend class Config;
+
+            View(Config* config, size_t node, size_t missing = NO_SLOT) : _config(config), _node(node), _missing(missing) {}
+
+            // resolves the path node of the section, NO_SLOT if no flag has the section as its prefix yet
+            size_t node() const;
+
+            // finds the slot of a relative flag with a value, NO_SLOT if not found
+            size_t findSlot(const char* key, size_t length) const;
+
+            // The Config object owning the section
+            Config* _config;
+
+            // The path node of the section, NO_SLOT until a missing section is resolved
+            mutable size_t _node;
+
+            // Position of a section without a path node in Config::_missingSections, or NO_SLOT
+            size_t _missing;
     };
 
+    template <> inline int Value::as<int>() const { return _int; }
+    template <> inline int64_t Value::as<int64_t>() const { return _int64; }
+    template <> inline double Value::as<double>() const { return _number; }
+    template <> inline bool Value::as<bool>() const { return _bool; }
+    template <> inline const char* Value::as<const char*>() const { return stringData(); }
+    template <> inline std::string Value::as<std::string>() const { return std::string(stringData(), _size); }
+    template <> inline Value::Array<int> Value::as<Value::Array<int> >() const { return Array<int>(reinterpret_cast<const int*>(arrayData()), _size); }
+    template <> inline Value::Array<double> Value::as<Value::Array<double> >() const { return Array<double>(reinterpret_cast<const double*>(arrayData()), _size); }
+    template <> inline Value::Array<bool> Value::as<Value::Array<bool> >() const { return Array<bool>(reinterpret_cast<const bool*>(arrayData()), _size); }
+    template <> inline Value::Array<const char*> Value::as<Value::Array<const char*> >() const { return Array<const char*>(reinterpret_cast<const char* const*>(arrayData()), _size); }
+
+    template <> inline Value::DataType Value::typeOf<int>() { return DataType::INT; }
+    template <> inline Value::DataType Value::typeOf<int64_t>() { return DataType::INT64; }
+    template <> inline Value::DataType Value::typeOf<double>() { return DataType::NUMBER; }
+    template <> inline Value::DataType Value::typeOf<bool>() { return DataType::BOOL; }
+    template <> inline Value::DataType Value::typeOf<const char*>() { return DataType::STRING; }
+    template <> inline Value::DataType Value::typeOf<std::string>() { return DataType::STRING; }
+    template <> inline Value::DataType Value::typeOf<Value::Array<int> >() { return DataType::INT_ARRAY; }
+    template <> inline Value::DataType Value::typeOf<Value::Array<double> >() { return DataType::NUMBER_ARRAY; }
+    template <> inline Value::DataType Value::typeOf<Value::Array<bool> >() { return DataType::BOOL_ARRAY; }
+    template <> inline Value::DataType Value::typeOf<Value::Array<const char*> >() { return DataType::STRING_ARRAY; }
+
+    template <typename T>
+    Config::Handle<T> Config::handle(const std::string& flag)
+    {
+        size_t slot = lookupSlot(flag);
+        if (slot == NO_SLOT || !hasValue(slot)) {
+            log(LogLevel::WARNING, flag, "cannot create handle, option value is undefined");
+            return Handle<T>();
+        }
+        if (_optionValues[slot].type() != Value::typeOf<T>()) {
+            log(LogLevel::WARNING, flag, "cannot create handle, data type mismatch");
+            return Handle<T>();
+        }
+        return Handle<T>(&_optionValues[slot]);
+    }
+
+    template <typename T>
+    Config::Handle<T> Config::View::handle(const std::string& key) const
+    {
+        size_t slot = findSlot(key.data(), key.size());
+        if (slot == NO_SLOT || _config->_optionValues[slot].type() != Value::typeOf<T>()) {
+            return Handle<T>();
+        }
+        return Handle<T>(&_config->_optionValues[slot]);
+    }
+
 }
 
 // TODO: Stray arguments
 // TODO: Support choice (value must be chosen form a list)
 // TODO: Beautiful print, in help() and usage(), instead of printf()
-// TODO: Support array
 // TODO: Switch to JSON backend?
 
 #endif // __MINICONF_H__
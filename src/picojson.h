@@ -324,7 +324,7 @@ namespace picojson {
   GET(array, *u_.array_)
   GET(object, *u_.object_)
 #ifdef PICOJSON_USE_INT64
-  GET(double, (type_ == int64_type && (const_cast<value*>(this)->type_ = number_type, const_cast<value*>(this)->u_.number_ = u_.int64_), u_.number_))
+  GET(double, (type_ == int64_type && (const_cast<value*>(this)->type_ = number_type, (const_cast<value*>(this)->u_.number_ = u_.int64_)), u_.number_))
   GET(int64_t, u_.int64_)
 #else
   GET(double, u_.number_)
@@ -748,7 +748,7 @@ namespace picojson {
     return in.expect('}');
   }
   
-  template <typename Iter> inline std::string _parse_number(input<Iter>& in) {
+  template <typename Iter> inline std::string _parse_number(input<Iter>& in, bool localized = true) {
     std::string num_str;
     while (1) {
       int ch = in.getc();
@@ -757,8 +757,13 @@ namespace picojson {
         num_str.push_back(ch);
       } else if (ch == '.') {
 #if PICOJSON_USE_LOCALE
-        num_str += localeconv()->decimal_point;
+        if (localized) {
+          num_str += localeconv()->decimal_point;
+        } else {
+          num_str.push_back('.');
+        }
 #else
+        (void)localized;
         num_str.push_back('.');
 #endif
       } else {
@@ -769,6 +774,44 @@ namespace picojson {
     return num_str;
   }
   
+  // a context defining parse_number(begin, end) converts the number tokens itself, the
+  // decimal point of a token is always '.'
+  template <typename Context, typename Iter>
+  inline auto _parse_number_value(Context& ctx, input<Iter>& in, int)
+      -> decltype(ctx.parse_number(static_cast<const char*>(0), static_cast<const char*>(0))) {
+    std::string num_str = _parse_number(in, false);
+    return !num_str.empty() && ctx.parse_number(num_str.data(), num_str.data() + num_str.size());
+  }
+
+  template <typename Context, typename Iter>
+  inline bool _parse_number_value(Context& ctx, input<Iter>& in, long) {
+    double f;
+    char *endp;
+    std::string num_str = _parse_number(in);
+    if (num_str.empty()) {
+      return false;
+    }
+#ifdef PICOJSON_USE_INT64
+    {
+      errno = 0;
+      intmax_t ival = strtoimax(num_str.c_str(), &endp, 10);
+      if (errno == 0
+          && std::numeric_limits<int64_t>::min() <= ival
+          && ival <= std::numeric_limits<int64_t>::max()
+          && endp == num_str.c_str() + num_str.size()) {
+        ctx.set_int64(ival);
+        return true;
+      }
+    }
+#endif
+    f = strtod(num_str.c_str(), &endp);
+    if (endp == num_str.c_str() + num_str.size()) {
+      ctx.set_number(f);
+      return true;
+    }
+    return false;
+  }
+
   template <typename Context, typename Iter> inline bool _parse(Context& ctx, input<Iter>& in) {
     in.skip_ws();
     int ch = in.getc();
@@ -791,32 +834,8 @@ namespace picojson {
       return _parse_object(ctx, in);
     default:
       if (('0' <= ch && ch <= '9') || ch == '-') {
-        double f;
-        char *endp;
 	in.ungetc();
-        std::string num_str = _parse_number(in);
-        if (num_str.empty()) {
-          return false;
-        }
-#ifdef PICOJSON_USE_INT64
-        {
-          errno = 0;
-          intmax_t ival = strtoimax(num_str.c_str(), &endp, 10);
-          if (errno == 0
-              && std::numeric_limits<int64_t>::min() <= ival
-              && ival <= std::numeric_limits<int64_t>::max()
-              && endp == num_str.c_str() + num_str.size()) {
-            ctx.set_int64(ival);
-            return true;
-          }
-        }
-#endif
-        f = strtod(num_str.c_str(), &endp);
-        if (endp == num_str.c_str() + num_str.size()) {
-          ctx.set_number(f);
-          return true;
-        }
-        return false;
+        return _parse_number_value(ctx, in, 0);
       }
       break;
     }